@@ -0,0 +1,498 @@
+#ifndef BIQUAD_H
+#define BIQUAD_H
+
+/*  Robert Bristow-Johnson biquad coefficients, shared by the RBJ plugins.
+
+    The coefficients are normalised by a0 and the plugin gain is folded
+    into the feed-forward part, so one output sample is
+
+        out = b0 * in + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2
+
+    with the DF1 state kept in buf[4] = { x1, x2, y1, y2 } as before.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "vcf.h"
+#include "coef_table.h"
+
+#define BIQUAD_MAX_LANES            64
+#define BIQUAD_TILE                 16
+#define BIQUAD_BLOCK                 8
+#define BIQUAD_BLOCK_MIN            32
+#define BIQUAD_GAIN_TOLERANCE    1e-12
+#define BIQUAD_STATE_TOLERANCE    1e-5
+
+enum {
+  RBJ_LOWPASS,
+  RBJ_HIGHPASS,
+  RBJ_BANDPASS1,
+  RBJ_BANDPASS2,
+  RBJ_NOTCH,
+  RBJ_PEAK_EQ,
+  RBJ_LOW_SHELF,
+  RBJ_HIGH_SHELF
+};
+
+typedef struct {
+  double b0, b1, b2, a1, a2;
+} biquadCoefs;
+
+typedef double biquadBlockVec
+    __attribute__((vector_size(BIQUAD_BLOCK * sizeof(double))));
+
+/*  Structure-of-arrays state for up to BIQUAD_MAX_LANES filters that share
+    one set of coefficients.  Audio is moved in and out in tiles of
+    BIQUAD_TILE samples, interleaved by lane, so that the recursion for
+    one sample runs across all lanes at once.
+*/
+typedef struct {
+  double x1[BIQUAD_MAX_LANES];
+  double x2[BIQUAD_MAX_LANES];
+  double y1[BIQUAD_MAX_LANES];
+  double y2[BIQUAD_MAX_LANES];
+  double in[BIQUAD_TILE][BIQUAD_MAX_LANES];
+  double out[BIQUAD_TILE][BIQUAD_MAX_LANES];
+} biquadBank;
+
+/* Modulation inputs of a _cv instance, see rbjCVParams(). */
+typedef struct {
+  const coefTable *table;
+  double f0, freq_pitch, q0, dBgain0, gain;
+  const float *freq_in, *reso_in, *dBgain_in;
+} rbjCV;
+
+/* type is expected to be a constant so that the switch folds away */
+static inline void rbjCoefs(biquadCoefs *c, int type,
+    double iv_sin, double iv_cos, double q, double A, double gain)
+{
+  double iv_alpha = iv_sin / (Q_SCALE * q);
+  double iv_beta, inv_a0, a0, a1, a2, b0, b1, b2;
+  switch (type) {
+  case RBJ_LOWPASS:
+    b0 = (1.0 - iv_cos) / 2.0;
+    b1 = 1.0 - iv_cos;
+    b2 = b0;
+    break;
+  case RBJ_HIGHPASS:
+    b0 = (1.0 + iv_cos) / 2.0;
+    b1 = -1.0 - iv_cos;
+    b2 = b0;
+    break;
+  case RBJ_BANDPASS1:
+    b0 = q * iv_alpha;
+    b1 = 0;
+    b2 = -q * iv_alpha;
+    break;
+  case RBJ_BANDPASS2:
+    b0 = iv_alpha;
+    b1 = 0;
+    b2 = -iv_alpha;
+    break;
+  case RBJ_NOTCH:
+    b0 = 1;
+    b1 = -2.0 * iv_cos;
+    b2 = 1;
+    break;
+  case RBJ_PEAK_EQ:
+    b0 = 1.0 + iv_alpha * A;
+    b1 = -2.0 * iv_cos;
+    b2 = 1.0 - iv_alpha * A;
+    a0 = 1.0 + iv_alpha / A;
+    a1 = -2.0 * iv_cos;
+    a2 = 1.0 - iv_alpha / A;
+    break;
+  case RBJ_LOW_SHELF:
+    iv_beta = sqrt(A) / q;
+    b0 = A * (A + 1.0 - (A - 1.0) * iv_cos + iv_beta * iv_sin);
+    b1 = 2.0 * A * (A - 1.0 - (A + 1.0) * iv_cos);
+    b2 = A * (A + 1.0 - (A - 1.0) * iv_cos - iv_beta * iv_sin);
+    a0 = A + 1.0 + (A - 1.0) * iv_cos + iv_beta * iv_sin;
+    a1 = -2.0 * (A - 1.0 + (A + 1.0) * iv_cos);
+    a2 = A + 1.0 + (A - 1.0) * iv_cos - iv_beta * iv_sin;
+    break;
+  default:
+    iv_beta = sqrt(A) / q;
+    b0 = A * (A + 1.0 + (A - 1.0) * iv_cos + iv_beta * iv_sin);
+    b1 = -2.0 * A * (A - 1.0 + (A + 1.0) * iv_cos);
+    b2 = A * (A + 1.0 + (A - 1.0) * iv_cos - iv_beta * iv_sin);
+    a0 = A + 1.0 - (A - 1.0) * iv_cos + iv_beta * iv_sin;
+    a1 = 2.0 * (A - 1.0 - (A + 1.0) * iv_cos);
+    a2 = A + 1.0 - (A - 1.0) * iv_cos - iv_beta * iv_sin;
+    break;
+  }
+  if (type < RBJ_PEAK_EQ) {
+    a0 = 1.0 + iv_alpha;
+    a1 = -2.0 * iv_cos;
+    a2 = 1.0 - iv_alpha;
+  }
+  inv_a0 = 1.0 / a0;
+  c->b0 = gain * b0 * inv_a0;
+  c->b1 = gain * b1 * inv_a0;
+  c->b2 = gain * b2 * inv_a0;
+  c->a1 = a1 * inv_a0;
+  c->a2 = a2 * inv_a0;
+}
+
+/*  Filter parameters from the control ports, as in the static run
+    functions, see rbjCVParams().
+*/
+static inline void rbjControlParams(int type, double rate, float freq_ofs,
+    float freq_pitch, float reso_ofs, float dBgain, double *iv_sin,
+    double *iv_cos, double *q, double *A)
+{
+  double f, pi2_f;
+  f = freq_ofs * ((freq_pitch > 0)
+                  ? 1.0 + freq_pitch / 2.0
+                  : 1.0 / (1.0 - freq_pitch / 2.0));
+  if (f < MIN_FREQ)
+    f = MIN_FREQ;
+  if (f > MAX_FREQ)
+    f = MAX_FREQ;
+  *q = reso_ofs;
+  if (*q < Q_MIN)
+    *q = Q_MIN;
+  if (*q > Q_MAX)
+    *q = Q_MAX;
+  *A = 1.0;
+  if (type >= RBJ_PEAK_EQ)
+    *A = exp(dBgain / 40.0 * log(10.0));
+  pi2_f = 2.0 * M_PI / rate * f;
+  *iv_sin = sin(pi2_f);
+  *iv_cos = cos(pi2_f);
+}
+
+/* Coefficients from the control ports, as in the static run functions */
+static inline void rbjControlCoefs(biquadCoefs *c, int type, double rate,
+    float gain, float freq_ofs, float freq_pitch, float reso_ofs,
+    float dBgain)
+{
+  double iv_sin, iv_cos, q, A;
+  rbjControlParams(type, rate, freq_ofs, freq_pitch, reso_ofs, dBgain,
+                   &iv_sin, &iv_cos, &q, &A);
+  rbjCoefs(c, type, iv_sin, iv_cos, q, A, gain);
+}
+
+/*  Filter parameters for sample i of a _cv block: sin and cos of the
+    normalised cutoff, the clamped resonance and the shelf/peak amplitude
+    A.  conn is the set of connected CV inputs and is expected to be a
+    constant; with none connected the parameters are computed exactly,
+    as in the static plugins, otherwise from the tables.
+*/
+static inline void rbjCVParams(int type, int conn, const rbjCV *cv,
+    uint32_t i, double *iv_sin, double *iv_cos, double *q, double *A)
+{
+  double f;
+  f = ((conn & CV_FREQ) && (cv->freq_in[i] > 0))
+      ? (cv->freq_in[i] * MAX_FREQ + cv->f0 - MIN_FREQ) * cv->freq_pitch
+      : cv->f0 * cv->freq_pitch;
+  if (f < MIN_FREQ)
+    f = MIN_FREQ;
+  if (f > MAX_FREQ)
+    f = MAX_FREQ;
+  *q = (conn & CV_RESO) ? cv->q0 + cv->reso_in[i] : cv->q0;
+  if (*q < Q_MIN)
+    *q = Q_MIN;
+  if (*q > Q_MAX)
+    *q = Q_MAX;
+  *A = 1.0;
+  if (!conn) {
+    if (type >= RBJ_PEAK_EQ)
+      *A = exp(cv->dBgain0 / 40.0 * log(10.0));
+    *iv_sin = sin(cv->table->pi2_rate * f);
+    *iv_cos = cos(cv->table->pi2_rate * f);
+  }
+  else {
+    if (type >= RBJ_PEAK_EQ)
+      *A = coefTableDbToA((conn & CV_DBGAIN)
+                          ? cv->dBgain0 + DBGAIN_SCALE * cv->dBgain_in[i]
+                          : cv->dBgain0);
+    coefTableSinCos(cv->table, f, iv_sin, iv_cos);
+  }
+}
+
+/* Coefficients for sample i of a _cv block, see rbjCVParams() */
+static inline void rbjCVCoefs(
+    biquadCoefs *c, int type, int conn, const rbjCV *cv, uint32_t i)
+{
+  double iv_sin, iv_cos, q, A;
+  rbjCVParams(type, conn, cv, i, &iv_sin, &iv_cos, &q, &A);
+  rbjCoefs(c, type, iv_sin, iv_cos, q, A, cv->gain);
+}
+
+/*  rbjCoefs() for lanes [0, lanes), one array per coefficient.  Written
+    as a plain loop over arrays so that, inlined with a constant type, it
+    vectorises across the lanes.
+*/
+static inline void rbjLaneCoefs(
+    double *restrict b0, double *restrict b1, double *restrict b2,
+    double *restrict a1, double *restrict a2, int type,
+    const double *restrict iv_sin, const double *restrict iv_cos,
+    const double *restrict q, const double *restrict A, double gain,
+    uint32_t lanes)
+{
+  biquadCoefs lane;
+  uint32_t l1;
+  for (l1 = 0; l1 < lanes; l1++) {
+    rbjCoefs(&lane, type, iv_sin[l1], iv_cos[l1], q[l1], A[l1], gain);
+    b0[l1] = lane.b0;
+    b1[l1] = lane.b1;
+    b2[l1] = lane.b2;
+    a1[l1] = lane.a1;
+    a2[l1] = lane.a2;
+  }
+}
+
+static inline float biquadTick(const biquadCoefs *c, double *buf, float in)
+{
+  float out = c->b0 * in + c->b1 * buf[0] + c->b2 * buf[1]
+      - c->a1 * buf[2] - c->a2 * buf[3];
+  buf[1] = buf[0];
+  buf[0] = in;
+  buf[3] = buf[2];
+  buf[2] = out;
+  return out;
+}
+
+/*  Block form of biquadRun() for fixed coefficients, BIQUAD_BLOCK
+    outputs per step.  With w[k] = b0 * x[k] + b1 * x[k-1] + b2 * x[k-2]
+    the outputs of one block are
+
+        y[k] = sum(j <= k) h[k-j] * w[j] + p1[k] * y[-1] + p2[k] * y[-2]
+
+    where h is the impulse response of the poles and p1, p2 their response
+    to the state left by the previous block.  Only the last two terms
+    depend on that block, so the serial chain is two multiply-adds per
+    block instead of per sample and the rest runs at SIMD width.  The
+    outputs differ from the sample loop by rounding only: y[-1] and y[-2]
+    are kept in double rather than rounded to float.
+*/
+static inline void biquadRunBlock(const biquadCoefs *c, double *buf,
+    const float *input, float *output, uint32_t len)
+{
+  biquadBlockVec h[BIQUAD_BLOCK], p1, p2, y;
+  double x[BIQUAD_BLOCK + 2], w[BIQUAD_BLOCK], imp[BIQUAD_BLOCK];
+  double y1 = buf[2], y2 = buf[3];
+  uint32_t l1, l2, l3;
+  imp[0] = 1.0;
+  imp[1] = -c->a1;
+  p1[0] = -c->a1;
+  p2[0] = -c->a2;
+  p1[1] = -c->a1 * p1[0] - c->a2;
+  p2[1] = -c->a1 * p2[0];
+  for (l1 = 2; l1 < BIQUAD_BLOCK; l1++) {
+    imp[l1] = -c->a1 * imp[l1 - 1] - c->a2 * imp[l1 - 2];
+    p1[l1] = -c->a1 * p1[l1 - 1] - c->a2 * p1[l1 - 2];
+    p2[l1] = -c->a1 * p2[l1 - 1] - c->a2 * p2[l1 - 2];
+  }
+  for (l2 = 0; l2 < BIQUAD_BLOCK; l2++)
+    for (l3 = 0; l3 < BIQUAD_BLOCK; l3++)
+      h[l2][l3] = (l3 >= l2) ? imp[l3 - l2] : 0;
+  x[0] = buf[1];
+  x[1] = buf[0];
+  for (l1 = 0; l1 + BIQUAD_BLOCK <= len; l1 += BIQUAD_BLOCK) {
+    for (l2 = 0; l2 < BIQUAD_BLOCK; l2++)
+      x[l2 + 2] = input[l1 + l2];
+    for (l2 = 0; l2 < BIQUAD_BLOCK; l2++)
+      w[l2] = c->b0 * x[l2 + 2] + c->b1 * x[l2 + 1] + c->b2 * x[l2];
+    y = p1 * y1 + p2 * y2;
+    for (l2 = 0; l2 < BIQUAD_BLOCK; l2++)
+      y += h[l2] * w[l2];
+    for (l3 = 0; l3 < BIQUAD_BLOCK; l3++)
+      output[l1 + l3] = y[l3];
+    x[0] = x[BIQUAD_BLOCK];
+    x[1] = x[BIQUAD_BLOCK + 1];
+    y1 = y[BIQUAD_BLOCK - 1];
+    y2 = y[BIQUAD_BLOCK - 2];
+  }
+  buf[0] = x[1];
+  buf[1] = x[0];
+  buf[2] = y1;
+  buf[3] = y2;
+  for (; l1 < len; l1++)
+    output[l1] = biquadTick(c, buf, input[l1]);
+}
+
+static inline void biquadRun(const biquadCoefs *c, double *buf,
+    const float *input, float *output, uint32_t len)
+{
+  uint32_t l1;
+  if (len >= BIQUAD_BLOCK_MIN) {
+    biquadRunBlock(c, buf, input, output, len);
+    return;
+  }
+  for (l1 = 0; l1 < len; l1++)
+    output[l1] = biquadTick(c, buf, input[l1]);
+}
+
+/*  Nonzero if the zeros of c cancel its poles, b1 = b0 * a1 and
+    b2 = b0 * a2, so that it reduces to out = b0 * in; *gain is set to b0.
+    This is the case for peak_eq and the shelves at 0 dB and for every
+    filter at gain 0.
+*/
+static inline int biquadGain(const biquadCoefs *c, double *gain)
+{
+  if (fabs(c->b1 - c->b0 * c->a1) > BIQUAD_GAIN_TOLERANCE
+      || fabs(c->b2 - c->b0 * c->a2) > BIQUAD_GAIN_TOLERANCE)
+    return 0;
+  *gain = c->b0;
+  return 1;
+}
+
+/*  Nonzero if the state is the one a plain gain would leave, y = gain * x
+    up to the float rounding of the outputs.  Right after the coefficients
+    become trivial the tail of the previous response is still in y1 and
+    y2; the full recursion keeps running, which fades it out at the rate
+    of the poles, until this holds.
+*/
+static inline int biquadStateAtGain(
+    double x1, double x2, double y1, double y2, double gain)
+{
+  return fabs(y1 - gain * x1)
+             < SILENCE_LIMIT + BIQUAD_STATE_TOLERANCE * fabs(gain * x1)
+      && fabs(y2 - gain * x2)
+             < SILENCE_LIMIT + BIQUAD_STATE_TOLERANCE * fabs(gain * x2);
+}
+
+/* Run a biquad that reduces to a gain as a copy, scale or zero fill */
+static inline void biquadRunGain(double gain, double *buf,
+    const float *input, float *output, uint32_t len)
+{
+  uint32_t l1;
+  if (len == 0)
+    return;
+  buf[1] = (len > 1) ? input[len - 2] : buf[0];
+  buf[0] = input[len - 1];
+  buf[2] = gain * buf[0];
+  buf[3] = gain * buf[1];
+  if (gain == 1.0) {
+    if (output != input)
+      memcpy(output, input, len * sizeof(float));
+  }
+  else if (gain == 0) {
+    memset(output, 0, len * sizeof(float));
+  }
+  else {
+    for (l1 = 0; l1 < len; l1++)
+      output[l1] = gain * input[l1];
+  }
+}
+
+/*  biquadRun() for coefficients that stay fixed over several blocks:
+    short-circuits the identity, gain and mute settings once the state
+    has settled on them.
+*/
+static inline void biquadRunFixed(const biquadCoefs *c, double *buf,
+    const float *input, float *output, uint32_t len)
+{
+  double gain;
+  if (biquadGain(c, &gain)
+      && biquadStateAtGain(buf[0], buf[1], buf[2], buf[3], gain))
+    biquadRunGain(gain, buf, input, output, len);
+  else
+    biquadRun(c, buf, input, output, len);
+}
+
+/* Run len samples while moving *c linearly onto *target. */
+static inline void biquadRunRamp(biquadCoefs *c, const biquadCoefs *target,
+    double *buf, const float *input, float *output, uint32_t len)
+{
+  biquadCoefs step;
+  double inv_len = 1.0 / len;
+  uint32_t l1;
+  step.b0 = (target->b0 - c->b0) * inv_len;
+  step.b1 = (target->b1 - c->b1) * inv_len;
+  step.b2 = (target->b2 - c->b2) * inv_len;
+  step.a1 = (target->a1 - c->a1) * inv_len;
+  step.a2 = (target->a2 - c->a2) * inv_len;
+  for (l1 = 0; l1 < len; l1++) {
+    c->b0 += step.b0;
+    c->b1 += step.b1;
+    c->b2 += step.b2;
+    c->a1 += step.a1;
+    c->a2 += step.a2;
+    output[l1] = biquadTick(c, buf, input[l1]);
+  }
+  *c = *target;
+}
+
+/*  run() of a _cv instance: fixed coefficients when no CV is connected,
+    coefficients per run of constant CV values at mod_step 1, else ramped
+    between every mod_step samples.  Idle blocks are skipped, see
+    runSilent(); the ramp then restarts from the CVs when the input
+    resumes.  type and conn are expected to be constants.
+*/
+static inline void rbjCVRun(const rbjCV *cv, int type, int conn,
+    biquadCoefs *coefs, int *coefs_valid, double *buf, const float *input,
+    float *output, uint32_t sample_count, uint32_t mod_step)
+{
+  biquadCoefs c;
+  uint32_t l1, len;
+  if (runSilent(input, output, buf, 4, sample_count)) {
+    *coefs_valid = 0;
+    return;
+  }
+  if (!conn || mod_step == 1)
+    *coefs_valid = 0;
+  if (!conn) {
+    rbjCVCoefs(&c, type, conn, cv, 0);
+    biquadRunFixed(&c, buf, input, output, sample_count);
+  }
+  else if (mod_step > 1) {
+    if (!*coefs_valid)
+      rbjCVCoefs(coefs, type, conn, cv, 0);
+    *coefs_valid = 1;
+    for (l1 = 0; l1 < sample_count; l1 += len) {
+      len = sample_count - l1;
+      if (len > mod_step)
+        len = mod_step;
+      rbjCVCoefs(&c, type, conn, cv, l1 + len - 1);
+      biquadRunRamp(coefs, &c, buf, input + l1, output + l1, len);
+    }
+  }
+  else {
+    for (l1 = 0; l1 < sample_count; l1 += len) {
+      len = cvRunLength(conn, cv->freq_in, cv->reso_in, cv->dBgain_in,
+                        l1, sample_count);
+      rbjCVCoefs(&c, type, conn, cv, l1);
+      biquadRun(&c, buf, input + l1, output + l1, len);
+    }
+  }
+}
+
+static inline void biquadBankReset(biquadBank *bank)
+{
+  int l1;
+  for (l1 = 0; l1 < BIQUAD_MAX_LANES; l1++)
+    bank->x1[l1] = bank->x2[l1] = bank->y1[l1] = bank->y2[l1] = 0;
+}
+
+/*  Filter the first len rows of bank->in into bank->out.  Meant to be
+    inlined into a VCF_SIMD caller.
+*/
+static inline void biquadBankRun(
+    const biquadCoefs *c, biquadBank *bank, uint32_t lanes, uint32_t len)
+{
+  double b0 = c->b0, b1 = c->b1, b2 = c->b2, a1 = c->a1, a2 = c->a2;
+  double *restrict x1 = bank->x1;
+  double *restrict x2 = bank->x2;
+  double *restrict y1 = bank->y1;
+  double *restrict y2 = bank->y2;
+  uint32_t l1, l2;
+  for (l1 = 0; l1 < len; l1++) {
+    const double *restrict x = bank->in[l1];
+    double *restrict y = bank->out[l1];
+    for (l2 = 0; l2 < lanes; l2++) {
+      y[l2] = b0 * x[l2] + b1 * x1[l2] + b2 * x2[l2]
+          - a1 * y1[l2] - a2 * y2[l2];
+      x2[l2] = x1[l2];
+      x1[l2] = x[l2];
+      y2[l2] = y1[l2];
+      y1[l2] = y[l2];
+    }
+  }
+}
+
+#endif
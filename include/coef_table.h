@@ -0,0 +1,187 @@
+#ifndef COEF_TABLE_H
+#define COEF_TABLE_H
+
+/*  Coefficient lookup tables for the audio-rate CV paths.
+
+    sin() and cos() of the normalised angular frequency are tabulated on a
+    log-frequency grid: every octave from 2^COEF_OCT_MIN Hz upwards is split
+    into 2^COEF_OCT_BITS equal steps, so the table index is simply the
+    exponent and the top mantissa bits of the (double) frequency.  Between
+    two grid points the angle addition theorem is applied with a short
+    Taylor series for the residual angle, which needs no division and no
+    libm call.
+
+    A = 10^(dBgain/40) is computed as 2^x from a table of 2^(j/64) and a
+    cubic polynomial for the remainder.
+
+    Error bounds against the double precision libm results, for
+    frequencies in [MIN_FREQ, MAX_FREQ]:
+
+        sin, cos    < 2e-8 absolute at 22050 Hz,
+                    < 1e-9 absolute at 44100 Hz and above
+        A           < 1e-9 relative
+
+    The sin/cos table depends on the sample rate; it is built in
+    instantiate() and shared by every instance running at that rate.  LV2
+    lets a host instantiate and clean up different instances from
+    different threads at once, so the table list and the reference counts
+    are guarded by coef_tables_lock.  run() does not take it: a table is
+    not changed once built, and the 2^(j/64) table is a constant.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "vcf.h"
+
+#define COEF_OCT_MIN           4
+#define COEF_OCT_COUNT        11
+#define COEF_OCT_BITS          6
+#define COEF_TABLE_SIZE     (COEF_OCT_COUNT << COEF_OCT_BITS)
+#define COEF_EXP2_BITS         6
+#define COEF_EXP2_SIZE      (1 << COEF_EXP2_BITS)
+
+#if MIN_FREQ < (1 << COEF_OCT_MIN) \
+    || MAX_FREQ >= (1 << (COEF_OCT_MIN + COEF_OCT_COUNT))
+#error "coefficient table does not cover [MIN_FREQ, MAX_FREQ]"
+#endif
+
+typedef struct coefTable {
+  double rate, pi2_rate;
+  double sincos[COEF_TABLE_SIZE][2];
+  int refcount;
+  struct coefTable *next;
+} coefTable;
+
+static coefTable *coef_tables = NULL;
+static pthread_mutex_t coef_tables_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* 2^(j/COEF_EXP2_SIZE) */
+static const double coef_exp2[COEF_EXP2_SIZE] = {
+  1, 1.0108892860517005, 1.0218971486541166,
+  1.0330248790212284, 1.0442737824274138, 1.0556451783605572,
+  1.0671404006768237, 1.0787607977571199, 1.0905077326652577,
+  1.1023825833078409, 1.1143867425958924, 1.1265216186082418,
+  1.1387886347566916, 1.1511892299529827, 1.1637248587775775,
+  1.1763969916502812, 1.189207115002721, 1.2021567314527031,
+  1.215247359980469, 1.22848053610687, 1.241857812073484,
+  1.2553807570246911, 1.2690509571917332, 1.2828700160787783,
+  1.2968395546510096, 1.3109612115247644, 1.3252366431597413,
+  1.3396675240533029, 1.3542555469368927, 1.3690024229745905,
+  1.383909881963832, 1.3989796725383112, 1.4142135623730951,
+  1.42961333839197, 1.4451808069770467, 1.460917794180647,
+  1.4768261459394993, 1.4929077282912648, 1.5091644275934228,
+  1.5255981507445384, 1.5422108254079407, 1.5590044002378369,
+  1.5759808451078865, 1.593142151342267, 1.6104903319492543,
+  1.6280274218573478, 1.6457554781539649, 1.6636765803267364,
+  1.681792830507429, 1.7001063537185235, 1.7186192981224779,
+  1.7373338352737062, 1.7562521603732995, 1.7753764925265212,
+  1.7947090750031072, 1.8142521755003989, 1.8340080864093424,
+  1.8539791250833855, 1.8741676341103, 1.8945759815869656,
+  1.9152065613971474, 1.9360617934922943, 1.9571441241754002,
+  1.9784560263879509
+};
+
+static inline coefTable *coefTableAcquire(double rate)
+{
+  coefTable *table;
+  int l1;
+  pthread_mutex_lock(&coef_tables_lock);
+  for (table = coef_tables; table; table = table->next) {
+    if (table->rate == rate) {
+      table->refcount++;
+      pthread_mutex_unlock(&coef_tables_lock);
+      return table;
+    }
+  }
+  table = (coefTable *)malloc(sizeof(coefTable));
+  if (!table) {
+    pthread_mutex_unlock(&coef_tables_lock);
+    return NULL;
+  }
+  table->rate = rate;
+  table->pi2_rate = 2.0 * M_PI / rate;
+  for (l1 = 0; l1 < COEF_TABLE_SIZE; l1++) {
+    double f = ldexp(1.0 + (double)(l1 & ((1 << COEF_OCT_BITS) - 1))
+                            / (1 << COEF_OCT_BITS),
+                     COEF_OCT_MIN + (l1 >> COEF_OCT_BITS));
+    table->sincos[l1][0] = sin(table->pi2_rate * f);
+    table->sincos[l1][1] = cos(table->pi2_rate * f);
+  }
+  table->refcount = 1;
+  table->next = coef_tables;
+  coef_tables = table;
+  pthread_mutex_unlock(&coef_tables_lock);
+  return table;
+}
+
+static inline void coefTableRelease(coefTable *table)
+{
+  coefTable **link;
+  pthread_mutex_lock(&coef_tables_lock);
+  if (--table->refcount > 0) {
+    pthread_mutex_unlock(&coef_tables_lock);
+    return;
+  }
+  for (link = &coef_tables; *link; link = &(*link)->next) {
+    if (*link == table) {
+      *link = table->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&coef_tables_lock);
+  free(table);
+}
+
+/*  f must lie in [MIN_FREQ, MAX_FREQ].  The bits are moved with memcpy()
+    and the table is indexed directly so that a loop over lanes calling
+    this can be vectorised with gathers.
+*/
+static inline void coefTableSinCos(
+    const coefTable *table, double f, double *iv_sin, double *iv_cos)
+{
+  uint64_t bits, i;
+  double base, x, x2, sx, cx;
+  memcpy(&bits, &f, sizeof(bits));
+  i = (bits >> (52 - COEF_OCT_BITS))
+      - ((uint64_t)(1023 + COEF_OCT_MIN) << COEF_OCT_BITS);
+  bits &= ~((UINT64_C(1) << (52 - COEF_OCT_BITS)) - 1);
+  memcpy(&base, &bits, sizeof(base));
+  x = table->pi2_rate * (f - base);
+  x2 = x * x;
+  sx = x * (1.0 - x2 * (1.0 / 6.0));
+  cx = 1.0 - x2 * (0.5 - x2 * (1.0 / 24.0));
+  *iv_sin = table->sincos[i][0] * cx + table->sincos[i][1] * sx;
+  *iv_cos = table->sincos[i][1] * cx - table->sincos[i][0] * sx;
+}
+
+static inline double coefTableExp2(double x)
+{
+  uint64_t bits;
+  double scale, xs, y;
+  int i;
+  if (x < -1000.0)
+    x = -1000.0;
+  if (x > 1000.0)
+    x = 1000.0;
+  xs = x * COEF_EXP2_SIZE;
+  i = (int)xs;
+  if (xs < i)
+    i--;
+  y = (xs - i) * (M_LN2 / COEF_EXP2_SIZE);
+  bits = (uint64_t)((i >> COEF_EXP2_BITS) + 1023) << 52;
+  memcpy(&scale, &bits, sizeof(scale));
+  return scale * coef_exp2[i & (COEF_EXP2_SIZE - 1)]
+      * (1.0 + y * (1.0 + y * (0.5 + y * (1.0 / 6.0))));
+}
+
+/* 10^(dBgain/40), the RBJ "A" */
+static inline double coefTableDbToA(double dBgain)
+{
+  return coefTableExp2(dBgain * (M_LN10 / M_LN2 / 40.0));
+}
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef FILTER_CROSSOVER_H
+#define FILTER_CROSSOVER_H
+
+/*  Linkwitz-Riley crossovers: 2, 3 and 4 band outputs split at 1, 2 and
+    3 frequencies by LR4 lowpass/highpass pairs, each the square of the
+    Butterworth biquad of the lowpass and highpass plugins.
+
+    The splits are applied in turn, the highpass output of one feeding
+    the next.  The LR4 lowpass and highpass at one frequency sum to the
+    allpass with the same denominator, so a band split off early is run
+    through the allpasses of the splits after it, which keeps the bands
+    in phase and their sum flat:
+
+        band 0 = LP1 AP2 AP3, band 1 = HP1 LP2 AP3, ... sum = AP1 AP2 AP3
+
+    Port layout: the input, the band outputs from the lowest up, gain,
+    then the split frequencies from the lowest up.
+
+    All splits and allpasses run in one pass over the audio, a tile at a
+    time, see xoverRun().  The lowpass and highpass of a split take one
+    input and share their denominator, so they run as the two lanes of
+    one vector, as do the two bands that go through the last allpass of
+    a 4 way crossover.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <lv2.h>
+
+#include "biquad.h"
+#include "sos.h"
+
+#define XOVER_DESCRIPTORS      3
+#define XOVER_MAX_SPLITS       3
+#define XOVER_MAX_BANDS        (XOVER_MAX_SPLITS + 1)
+#define XOVER_TILE            64
+/* state of a split: two sections of x1, x2, y1, y2 for two lanes */
+#define XOVER_SPLIT_STATE     16
+#define XOVER_ALLPASS_STATE    8
+#define XOVER_STATE            (XOVER_MAX_SPLITS \
+                                * (XOVER_SPLIT_STATE + XOVER_ALLPASS_STATE))
+
+static const uint32_t xover_splits[XOVER_DESCRIPTORS] = { 1, 2, 3 };
+
+typedef struct {
+  float *input;
+  float *output[XOVER_MAX_BANDS];
+  float *gain;
+  float *freq[XOVER_MAX_SPLITS];
+  uint32_t splits;
+  double rate;
+  controlCache controls;
+  biquadCoefs lowpass[XOVER_MAX_SPLITS];
+  biquadCoefs highpass[XOVER_MAX_SPLITS];
+  double buf[XOVER_STATE];
+  uint32_t denormal_flushes;
+} filtCrossover;
+
+static LV2_Handle instantiateFiltCrossover(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    LV2_Descriptor **descriptors)
+{
+  filtCrossover *plugin_data;
+  int l1;
+  for (l1 = 0; l1 < XOVER_DESCRIPTORS; l1++)
+    if (descriptors[l1] == descriptor)
+      break;
+  if (l1 == XOVER_DESCRIPTORS)
+    return NULL;
+  plugin_data = (filtCrossover *)calloc(1, sizeof(filtCrossover));
+  if (!plugin_data)
+    return NULL;
+  plugin_data->splits = xover_splits[l1];
+  plugin_data->rate = s_rate;
+  return (LV2_Handle)plugin_data;
+}
+
+static void cleanupFiltCrossover(LV2_Handle instance)
+{
+  free(instance);
+}
+
+static void connectPortFiltCrossover(
+    LV2_Handle instance, uint32_t port, void *data)
+{
+  filtCrossover *plugin = (filtCrossover *)instance;
+  uint32_t bands = plugin->splits + 1;
+  if (port == 0)
+    plugin->input = data;
+  else if (port <= bands)
+    plugin->output[port - 1] = data;
+  else if (port == bands + 1)
+    plugin->gain = data;
+  else if (port - bands - 2 < plugin->splits)
+    plugin->freq[port - bands - 2] = data;
+}
+
+static void activateFiltCrossover(LV2_Handle instance)
+{
+  filtCrossover *plugin_data = (filtCrossover *)instance;
+  memset(plugin_data->buf, 0, sizeof(plugin_data->buf));
+}
+
+/* Lowpass and highpass of every split, from one sin and cos each */
+static inline void designFiltCrossover(filtCrossover *pluginData,
+    const float *controls)
+{
+  double q = sos_linkwitz_riley_q[1][0] * (2.0 / Q_SCALE);
+  double f, pi2_f, iv_sin, iv_cos;
+  uint32_t l1;
+  for (l1 = 0; l1 < pluginData->splits; l1++) {
+    f = controls[l1];
+    if (f < MIN_FREQ)
+      f = MIN_FREQ;
+    if (f > MAX_FREQ)
+      f = MAX_FREQ;
+    pi2_f = 2.0 * M_PI / pluginData->rate * f;
+    iv_sin = sin(pi2_f);
+    iv_cos = cos(pi2_f);
+    rbjCoefs(&pluginData->lowpass[l1], RBJ_LOWPASS, iv_sin, iv_cos, q, 1.0,
+             1.0);
+    rbjCoefs(&pluginData->highpass[l1], RBJ_HIGHPASS, iv_sin, iv_cos, q,
+             1.0, 1.0);
+  }
+}
+
+static inline sosHalf xoverLoad(const double *p)
+{
+  sosHalf v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline void xoverStore(double *p, sosHalf v)
+{
+  memcpy(p, &v, sizeof(v));
+}
+
+/*  One split over a tile: x is replaced by the highpass output and the
+    lowpass output goes to lo.
+*/
+static inline void xoverSplit(const biquadCoefs *lp, const biquadCoefs *hp,
+    double *state, double *restrict x, double *restrict lo, uint32_t len)
+{
+  sosHalf b0 = { lp->b0, hp->b0 }, b1 = { lp->b1, hp->b1 };
+  sosHalf b2 = { lp->b2, hp->b2 };
+  sosHalf a1 = { lp->a1, lp->a1 }, a2 = { lp->a2, lp->a2 };
+  sosHalf x1[2], x2[2], y1[2], y2[2], v, y;
+  uint32_t s, t;
+  for (s = 0; s < 2; s++) {
+    x1[s] = xoverLoad(state + 8 * s);
+    x2[s] = xoverLoad(state + 8 * s + 2);
+    y1[s] = xoverLoad(state + 8 * s + 4);
+    y2[s] = xoverLoad(state + 8 * s + 6);
+  }
+  for (t = 0; t < len; t++) {
+    v = (sosHalf){ x[t], x[t] };
+    for (s = 0; s < 2; s++) {
+      y = b1 * x1[s] + b2 * x2[s] - a2 * y2[s] + b0 * v - a1 * y1[s];
+      x2[s] = x1[s];
+      x1[s] = v;
+      y2[s] = y1[s];
+      y1[s] = y;
+      v = y;
+    }
+    lo[t] = v[0];
+    x[t] = v[1];
+  }
+  for (s = 0; s < 2; s++) {
+    xoverStore(state + 8 * s, x1[s]);
+    xoverStore(state + 8 * s + 2, x2[s]);
+    xoverStore(state + 8 * s + 4, y1[s]);
+    xoverStore(state + 8 * s + 6, y2[s]);
+  }
+}
+
+/*  The allpass of the split with coefficients c, numerator a2, a1, 1,
+    over a tile of two bands.
+*/
+static inline void xoverAllpass(const biquadCoefs *c, double *state,
+    double *restrict lo, double *restrict hi, uint32_t len)
+{
+  sosHalf a1 = { c->a1, c->a1 }, a2 = { c->a2, c->a2 };
+  sosHalf x1 = xoverLoad(state), x2 = xoverLoad(state + 2);
+  sosHalf y1 = xoverLoad(state + 4), y2 = xoverLoad(state + 6);
+  sosHalf v, y;
+  uint32_t t;
+  for (t = 0; t < len; t++) {
+    v = (sosHalf){ lo[t], hi[t] };
+    y = a1 * x1 + x2 - a2 * y2 + a2 * v - a1 * y1;
+    x2 = x1;
+    x1 = v;
+    y2 = y1;
+    y1 = y;
+    lo[t] = y[0];
+    hi[t] = y[1];
+  }
+  xoverStore(state, x1);
+  xoverStore(state + 2, x2);
+  xoverStore(state + 4, y1);
+  xoverStore(state + 6, y2);
+}
+
+/*  Run len samples through all splits and allpasses, a tile of
+    XOVER_TILE samples at a time.  Each split and allpass runs over the
+    whole tile before the next, with its state and coefficients in
+    registers; the tile stays in L1 between them.  The allpass of the
+    second split only has the lowest band to run on, the other lane runs
+    on silence.
+*/
+static inline void xoverRun(filtCrossover *pluginData, uint32_t len)
+{
+  double x[XOVER_TILE], band[XOVER_MAX_SPLITS][XOVER_TILE];
+  double silence[XOVER_TILE];
+  double *buf = pluginData->buf;
+  double *allpass = buf + XOVER_SPLIT_STATE * XOVER_MAX_SPLITS;
+  float gain = *(pluginData->gain);
+  uint32_t splits = pluginData->splits;
+  uint32_t done, n, l1, t;
+  for (done = 0; done < len; done += n) {
+    n = (len - done < XOVER_TILE) ? len - done : XOVER_TILE;
+    for (t = 0; t < n; t++)
+      x[t] = gain * pluginData->input[done + t];
+    for (l1 = 0; l1 < splits; l1++)
+      xoverSplit(&pluginData->lowpass[l1], &pluginData->highpass[l1],
+                 buf + XOVER_SPLIT_STATE * l1, x, band[l1], n);
+    for (l1 = 1; l1 < splits; l1++) {
+      if (l1 == 1)
+        memset(silence, 0, n * sizeof(double));
+      xoverAllpass(&pluginData->lowpass[l1],
+                   allpass + XOVER_ALLPASS_STATE * l1, band[0],
+                   (l1 == 1) ? silence : band[1], n);
+    }
+    for (l1 = 0; l1 < splits; l1++)
+      for (t = 0; t < n; t++)
+        pluginData->output[l1][done + t] = band[l1][t];
+    for (t = 0; t < n; t++)
+      pluginData->output[splits][done + t] = x[t];
+  }
+}
+
+static inline void runFiltCrossover(filtCrossover *pluginData,
+    uint32_t sample_count)
+{
+  uint32_t splits = pluginData->splits;
+  float controls[XOVER_MAX_SPLITS];
+  uint32_t l1;
+  fpuMode mode;
+  if (blockZero(pluginData->input, sample_count)
+      && stateDecayed(pluginData->buf, XOVER_STATE)) {
+    memset(pluginData->buf, 0, sizeof(pluginData->buf));
+    for (l1 = 0; l1 <= splits; l1++)
+      memset(pluginData->output[l1], 0, sample_count * sizeof(float));
+    return;
+  }
+  mode = denormalsOff();
+  for (l1 = 0; l1 < splits; l1++)
+    controls[l1] = *(pluginData->freq[l1]);
+  if (controlsChanged(&pluginData->controls, controls, splits))
+    designFiltCrossover(pluginData, controls);
+  xoverRun(pluginData, sample_count);
+  pluginData->denormal_flushes += flushDenormals(pluginData->buf,
+                                                 XOVER_STATE);
+  denormalsRestore(mode);
+}
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef FILTER_DYNAMIC_H
+#define FILTER_DYNAMIC_H
+
+/*  _dyn variants of peak_eq and the shelves: dynamic EQ, the dB gain of
+    the band follows the level of the band in the input or a sidechain.
+
+    Port layout: the input, the output, the sidechain input, gain,
+    freq_ofs, freq_pitch, reso_ofs and dBgain_ofs as in the static
+    plugin, then threshold, ratio, range, attack, release, external and
+    the lv2:enabled port last.
+
+    The detector filters the key signal, the input or with external on
+    the sidechain, through the bandpass2 of the band for peak_eq and the
+    Butterworth lowpass or highpass at its frequency for the shelves.
+    Its envelope runs at control rate: once per tile of DYN_TILE samples
+    it takes the mean square of the tile, with one-pole attack and
+    release.  Where the level is over threshold the dB gain moves by
+    over * (1 - 1 / ratio), down for ratios above 1 and up below, by at
+    most range dB.  The coefficients for it are computed once per tile
+    and ramped to across the tile with biquadRunRamp(), so the exp() of
+    the dB gain is taken once per tile instead of per sample as in the
+    _cv plugins.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <lv2.h>
+
+#include "biquad.h"
+
+#define DYN_TILE              32
+#define DYN_LEVEL_FLOOR    1e-12
+
+typedef struct {
+  float *input;
+  float *output;
+  float *sidechain;
+  float *gain;
+  float *freq_ofs;
+  float *freq_pitch;
+  float *reso_ofs;
+  float *dBgain_ofs;
+  float *threshold;
+  float *ratio;
+  float *range;
+  float *attack;
+  float *release;
+  float *external;
+  controlCache controls;
+  double iv_sin, iv_cos, q;
+  biquadCoefs detector;
+  biquadCoefs coefs;
+  int coefs_valid;
+  double rate, buf[4], key_buf[4], env;
+  uint32_t denormal_flushes;
+  bypassFade bypass;
+} filtDynamic;
+
+static LV2_Handle instantiateFiltDynamic(double s_rate)
+{
+  filtDynamic *plugin_data = (filtDynamic *)calloc(1, sizeof(filtDynamic));
+  if (!plugin_data)
+    return NULL;
+  plugin_data->rate = s_rate;
+  bypassInit(&plugin_data->bypass);
+  return (LV2_Handle)plugin_data;
+}
+
+static void cleanupFiltDynamic(LV2_Handle instance)
+{
+  free(instance);
+}
+
+static void connectPortFiltDynamic(
+    LV2_Handle instance, uint32_t port, void *data)
+{
+  filtDynamic *plugin = (filtDynamic *)instance;
+  switch(port){
+    case 0:  plugin->input = data;          break;
+    case 1:  plugin->output = data;         break;
+    case 2:  plugin->sidechain = data;      break;
+    case 3:  plugin->gain = data;           break;
+    case 4:  plugin->freq_ofs = data;       break;
+    case 5:  plugin->freq_pitch = data;     break;
+    case 6:  plugin->reso_ofs = data;       break;
+    case 7:  plugin->dBgain_ofs = data;     break;
+    case 8:  plugin->threshold = data;      break;
+    case 9:  plugin->ratio = data;          break;
+    case 10: plugin->range = data;          break;
+    case 11: plugin->attack = data;         break;
+    case 12: plugin->release = data;        break;
+    case 13: plugin->external = data;       break;
+    case 14: plugin->bypass.enabled = data; break;
+  }
+}
+
+static void activateFiltDynamic(LV2_Handle instance)
+{
+  filtDynamic *plugin_data = (filtDynamic *)instance;
+  memset(plugin_data->buf, 0, sizeof(plugin_data->buf));
+  memset(plugin_data->key_buf, 0, sizeof(plugin_data->key_buf));
+  plugin_data->env = 0;
+  plugin_data->coefs_valid = 0;
+}
+
+/* The detector response for the band of type */
+static inline int dynamicDetector(int type)
+{
+  if (type == RBJ_LOW_SHELF)
+    return RBJ_LOWPASS;
+  return (type == RBJ_HIGH_SHELF) ? RBJ_HIGHPASS : RBJ_BANDPASS2;
+}
+
+/* One-pole coefficient for a time constant of ms over len samples */
+static inline double dynamicCoef(double rate, float ms, uint32_t len)
+{
+  return 1.0 - exp(-(double)len / (ms * 0.001 * rate));
+}
+
+/*  dB gain of the band for the envelope env, a mean square, see the
+    comment at the top.
+*/
+static inline double dynamicGain(const filtDynamic *pluginData, double env)
+{
+  double over = 10.0 * log10(env + DYN_LEVEL_FLOOR)
+      - *(pluginData->threshold);
+  double ratio = *(pluginData->ratio);
+  double range = fabs(*(pluginData->range));
+  double delta;
+  if (over <= 0 || ratio <= 0)
+    return *(pluginData->dBgain_ofs);
+  delta = -over * (1.0 - 1.0 / ratio);
+  if (delta > range)
+    delta = range;
+  if (delta < -range)
+    delta = -range;
+  return *(pluginData->dBgain_ofs) + delta;
+}
+
+/*  One tile: len samples through the band while moving *c linearly onto
+    *target, as biquadRunRamp(), and the key through the detector d in
+    the same loop, the two recursions being independent.  Returns the
+    mean square of the detector output.  The key may be the input, and
+    the output the input as well.
+*/
+static inline double dynamicTile(biquadCoefs *c, const biquadCoefs *target,
+    const biquadCoefs *d, double *buf, double *key_buf, const float *key,
+    const float *input, float *output, uint32_t len)
+{
+  double b0 = c->b0, b1 = c->b1, b2 = c->b2, a1 = c->a1, a2 = c->a2;
+  double inv_len = 1.0 / len;
+  double s_b0 = (target->b0 - b0) * inv_len;
+  double s_b1 = (target->b1 - b1) * inv_len;
+  double s_b2 = (target->b2 - b2) * inv_len;
+  double s_a1 = (target->a1 - a1) * inv_len;
+  double s_a2 = (target->a2 - a2) * inv_len;
+  double x1 = buf[0], x2 = buf[1], y1 = buf[2], y2 = buf[3];
+  double k1 = key_buf[0], k2 = key_buf[1], d1 = key_buf[2], d2 = key_buf[3];
+  double in, k, y, det, level = 0;
+  uint32_t l1;
+  for (l1 = 0; l1 < len; l1++) {
+    in = input[l1];
+    k = key[l1];
+    b0 += s_b0;
+    b1 += s_b1;
+    b2 += s_b2;
+    a1 += s_a1;
+    a2 += s_a2;
+    det = d->b1 * k1 + d->b2 * k2 - d->a2 * d2 + d->b0 * k - d->a1 * d1;
+    k2 = k1;
+    k1 = k;
+    d2 = d1;
+    d1 = det;
+    level += det * det;
+    y = b1 * x1 + b2 * x2 - a2 * y2 + b0 * in - a1 * y1;
+    x2 = x1;
+    x1 = in;
+    y2 = y1;
+    y1 = (float)y;
+    output[l1] = y1;
+  }
+  buf[0] = x1;
+  buf[1] = x2;
+  buf[2] = y1;
+  buf[3] = y2;
+  key_buf[0] = k1;
+  key_buf[1] = k2;
+  key_buf[2] = d1;
+  key_buf[3] = d2;
+  *c = *target;
+  return level * inv_len;
+}
+
+/*  run() of a _dyn instance; idle blocks are skipped, see runSilent(),
+    and the ramp restarts from the envelope when the input resumes.  The
+    band is ramped over each tile to the gain for the envelope up to the
+    tile before, so the detector of a tile runs in the same loop as the
+    band.  type is expected to be a constant.
+*/
+static inline void runFiltDynamic(
+    filtDynamic *pluginData, uint32_t sample_count, int type)
+{
+  float controls[3] = {
+    *(pluginData->freq_ofs), *(pluginData->freq_pitch),
+    *(pluginData->reso_ofs)
+  };
+  const float *key = (pluginData->sidechain && *(pluginData->external) > 0)
+      ? pluginData->sidechain : pluginData->input;
+  double att, rel, full_att, full_rel, level, A;
+  biquadCoefs target;
+  uint32_t l1, len;
+  fpuMode mode;
+  if (runSilent(pluginData->input, pluginData->output, pluginData->buf,
+                4, sample_count)) {
+    pluginData->coefs_valid = 0;
+    return;
+  }
+  mode = denormalsOff();
+  if (controlsChanged(&pluginData->controls, controls, 3)) {
+    rbjControlParams(type, pluginData->rate, controls[0], controls[1],
+                     controls[2], 0, &pluginData->iv_sin,
+                     &pluginData->iv_cos, &pluginData->q, &A);
+    rbjCoefs(&pluginData->detector, dynamicDetector(type),
+             pluginData->iv_sin, pluginData->iv_cos,
+             (type == RBJ_PEAK_EQ) ? pluginData->q
+                                   : M_SQRT1_2 * (2.0 / Q_SCALE), 1.0, 1.0);
+  }
+  full_att = dynamicCoef(pluginData->rate, *(pluginData->attack), DYN_TILE);
+  full_rel = dynamicCoef(pluginData->rate, *(pluginData->release),
+                         DYN_TILE);
+  for (l1 = 0; l1 < sample_count; l1 += len) {
+    len = sample_count - l1;
+    if (len > DYN_TILE)
+      len = DYN_TILE;
+    A = exp(dynamicGain(pluginData, pluginData->env) / 40.0 * log(10.0));
+    rbjCoefs(&target, type, pluginData->iv_sin, pluginData->iv_cos,
+             pluginData->q, A, *(pluginData->gain));
+    if (!pluginData->coefs_valid)
+      pluginData->coefs = target;
+    pluginData->coefs_valid = 1;
+    level = dynamicTile(&pluginData->coefs, &target, &pluginData->detector,
+                        pluginData->buf, pluginData->key_buf, key + l1,
+                        pluginData->input + l1, pluginData->output + l1,
+                        len);
+    att = (len == DYN_TILE) ? full_att
+        : dynamicCoef(pluginData->rate, *(pluginData->attack), len);
+    rel = (len == DYN_TILE) ? full_rel
+        : dynamicCoef(pluginData->rate, *(pluginData->release), len);
+    pluginData->env += ((level > pluginData->env) ? att : rel)
+        * (level - pluginData->env);
+  }
+  pluginData->denormal_flushes += flushDenormals(pluginData->buf, 4)
+      | flushDenormals(pluginData->key_buf, 4);
+  denormalsRestore(mode);
+}
+
+#endif
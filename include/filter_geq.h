@@ -0,0 +1,127 @@
+#ifndef FILTER_GEQ_H
+#define FILTER_GEQ_H
+
+/*  Graphic EQ: peaking bands at the ISO octave or third-octave centre
+    frequencies, with the formula of the peak_eq plugin and a fixed
+    bandwidth of one octave or one third of an octave.
+
+    Port layout: the input, the output, gain, the dB gain of each band
+    from the lowest up, then enabled.  A band recomputes its coefficients
+    only when its own control changes; the bands run in one pass through
+    sosBandsRun(), which leaves out those at 0 dB.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <lv2.h>
+
+#include "biquad.h"
+#include "sos.h"
+
+#define GEQ_DESCRIPTORS        2
+#define GEQ_MAX_BANDS         31
+
+static const uint32_t geq_bands[GEQ_DESCRIPTORS] = { 10, 31 };
+
+static const float geq_freq[GEQ_DESCRIPTORS][GEQ_MAX_BANDS] = {
+  { 31.5, 63, 125, 250, 500, 1000, 2000, 4000, 8000, 16000 },
+  { 20, 25, 31.5, 40, 50, 63, 80, 100, 125, 160, 200, 250, 315, 400, 500,
+    630, 800, 1000, 1250, 1600, 2000, 2500, 3150, 4000, 5000, 6300, 8000,
+    10000, 12500, 16000, 20000 }
+};
+
+/*  Resonance controls for Q 1.41 and 4.32, the Q of a peaking band one
+    octave and one third of an octave wide, see rbjCoefs()
+*/
+static const float geq_reso[GEQ_DESCRIPTORS] = {
+  1.41 * 2.0 / Q_SCALE, 4.32 * 2.0 / Q_SCALE
+};
+
+typedef struct {
+  float *input;
+  float *output;
+  float *gain;
+  float *dBgain[GEQ_MAX_BANDS];
+  const float *freq;
+  float reso;
+  uint32_t bands;
+  controlCache controls[GEQ_MAX_BANDS];
+  biquadCoefs coefs[GEQ_MAX_BANDS];
+  double rate, buf[4 * GEQ_MAX_BANDS];
+  uint32_t denormal_flushes;
+  bypassFade bypass;
+} filtGEQ;
+
+static LV2_Handle instantiateFiltGEQ(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    LV2_Descriptor **descriptors)
+{
+  filtGEQ *plugin_data;
+  int l1;
+  for (l1 = 0; l1 < GEQ_DESCRIPTORS; l1++)
+    if (descriptors[l1] == descriptor)
+      break;
+  if (l1 == GEQ_DESCRIPTORS)
+    return NULL;
+  plugin_data = (filtGEQ *)calloc(1, sizeof(filtGEQ));
+  if (!plugin_data)
+    return NULL;
+  plugin_data->bands = geq_bands[l1];
+  plugin_data->freq = geq_freq[l1];
+  plugin_data->reso = geq_reso[l1];
+  plugin_data->rate = s_rate;
+  bypassInit(&plugin_data->bypass);
+  return (LV2_Handle)plugin_data;
+}
+
+static void cleanupFiltGEQ(LV2_Handle instance)
+{
+  free(instance);
+}
+
+static void connectPortFiltGEQ(
+    LV2_Handle instance, uint32_t port, void *data)
+{
+  filtGEQ *plugin = (filtGEQ *)instance;
+  switch(port){
+    case 0: plugin->input = data;       return;
+    case 1: plugin->output = data;      return;
+    case 2: plugin->gain = data;        return;
+  }
+  port -= 3;
+  if (port < plugin->bands)
+    plugin->dBgain[port] = data;
+  else if (port == plugin->bands)
+    plugin->bypass.enabled = data;
+}
+
+static void activateFiltGEQ(LV2_Handle instance)
+{
+  filtGEQ *plugin_data = (filtGEQ *)instance;
+  memset(plugin_data->buf, 0, sizeof(plugin_data->buf));
+}
+
+static inline void runFiltGEQ(filtGEQ *pluginData, uint32_t sample_count)
+{
+  double *buf = pluginData->buf;
+  uint32_t bands = pluginData->bands;
+  uint32_t l1;
+  fpuMode mode;
+  if (runSilent(pluginData->input, pluginData->output, buf, 4 * bands,
+                sample_count))
+    return;
+  mode = denormalsOff();
+  for (l1 = 0; l1 < bands; l1++)
+    if (controlsChanged(&pluginData->controls[l1], pluginData->dBgain[l1],
+                        1))
+      rbjControlCoefs(&pluginData->coefs[l1], RBJ_PEAK_EQ, pluginData->rate,
+                      1.0, pluginData->freq[l1], 0, pluginData->reso,
+                      *(pluginData->dBgain[l1]));
+  sosBandsRun(pluginData->coefs, buf, bands, *(pluginData->gain),
+              pluginData->input, pluginData->output, sample_count);
+  pluginData->denormal_flushes += flushDenormals(buf, 4 * bands);
+  denormalsRestore(mode);
+}
+
+#endif
@@ -0,0 +1,261 @@
+#ifndef FILTER_HUM_H
+#define FILTER_HUM_H
+
+/*  Hum removal for the notch plugin: a cascade of notch biquads on the
+    mains fundamental and its harmonics, retuned to follow the drift of
+    the fundamental.
+
+    Port layout: the input, the output, gain, mains (50 or 60 Hz),
+    harmonics, the Q of the notches, tracking, the hum_freq output that
+    reports the fundamental the notches are tuned to, and the lv2:enabled
+    port last.
+
+    The fundamental is estimated from the input through two bandpass2
+    sections at the nominal mains frequency, run as one sosRun() cascade,
+    enough to keep the second harmonic from pulling the estimate up.  For
+    a sinusoid y of angular frequency w
+
+        y[n-1] - 2 y[n] + y[n+1] = -4 sin^2(w/2) y[n]
+
+    so the ratio of the sums of y[n] times its second difference and of
+    y[n]^2 gives w, at two multiply-adds a sample.  The sums are smoothed
+    with a time constant of HUM_SMOOTH seconds and the estimate is kept
+    within HUM_DRIFT of the nominal frequency.  The notches are retuned
+    once per tile of HUM_TILE samples, the harmonics from the sin and cos
+    of the fundamental by the angle addition formulas, so one sin and cos
+    a tile does for the whole cascade.  The notches run as sosRun()
+    cascades of up to SOS_MAX_SECTIONS sections.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <lv2.h>
+
+#include "biquad.h"
+#include "sos.h"
+
+#define HUM_MAX_HARMONICS      8
+#define HUM_CASCADES           (HUM_MAX_HARMONICS / SOS_MAX_SECTIONS)
+#define HUM_TILE              64
+#define HUM_DRIFT           0.02
+#define HUM_SMOOTH          0.25
+#define HUM_DETECTOR_Q       4.0
+#define HUM_LEVEL_FLOOR    1e-12
+/* notches up to this fraction of the sample rate */
+#define HUM_MAX_FRACTION    0.45
+/* state of the notches, then of the two detector sections */
+#define HUM_STATE              (4 * HUM_MAX_HARMONICS + 8)
+
+typedef struct {
+  float *input;
+  float *output;
+  float *gain;
+  float *mains;
+  float *harmonics;
+  float *q;
+  float *tracking;
+  float *hum_freq;
+  controlCache controls;
+  sosCascade detector;
+  sosCascade notch[HUM_CASCADES];
+  uint32_t notches;
+  double rate, nominal, freq, tuned, num, den, last[2];
+  double buf[HUM_STATE];
+  uint32_t denormal_flushes;
+  bypassFade bypass;
+} filtHum;
+
+static LV2_Handle instantiateFiltHum(double s_rate)
+{
+  filtHum *plugin_data = (filtHum *)calloc(1, sizeof(filtHum));
+  if (!plugin_data)
+    return NULL;
+  plugin_data->rate = s_rate;
+  bypassInit(&plugin_data->bypass);
+  return (LV2_Handle)plugin_data;
+}
+
+static void cleanupFiltHum(LV2_Handle instance)
+{
+  free(instance);
+}
+
+static void connectPortFiltHum(
+    LV2_Handle instance, uint32_t port, void *data)
+{
+  filtHum *plugin = (filtHum *)instance;
+  switch(port){
+    case 0: plugin->input = data;           break;
+    case 1: plugin->output = data;          break;
+    case 2: plugin->gain = data;            break;
+    case 3: plugin->mains = data;           break;
+    case 4: plugin->harmonics = data;       break;
+    case 5: plugin->q = data;               break;
+    case 6: plugin->tracking = data;        break;
+    case 7: plugin->hum_freq = data;        break;
+    case 8: plugin->bypass.enabled = data;  break;
+  }
+}
+
+static void activateFiltHum(LV2_Handle instance)
+{
+  filtHum *plugin_data = (filtHum *)instance;
+  memset(plugin_data->buf, 0, sizeof(plugin_data->buf));
+  plugin_data->last[0] = plugin_data->last[1] = 0;
+  plugin_data->controls.valid = 0;
+  plugin_data->num = 0;
+  plugin_data->den = 0;
+  plugin_data->freq = 0;
+}
+
+/*  The detector and the number of notches for the controls, mains,
+    harmonics and Q; the notches are retuned on the next tile, and the
+    estimate restarts from the nominal frequency when the mains setting
+    changes.
+*/
+static inline void designFiltHum(filtHum *pluginData, const float *controls)
+{
+  double nominal = (controls[0] < 55.0f) ? 50.0 : 60.0;
+  double pi2_f = 2.0 * M_PI / pluginData->rate * nominal;
+  int harmonics = (int)(controls[1] + 0.5f);
+  uint32_t notches = 0, l1;
+  if (harmonics < 1)
+    harmonics = 1;
+  if (harmonics > HUM_MAX_HARMONICS)
+    harmonics = HUM_MAX_HARMONICS;
+  while ((int)notches < harmonics && (notches + 1) * nominal
+         * (1.0 + HUM_DRIFT) < HUM_MAX_FRACTION * pluginData->rate)
+    notches++;
+  if (notches > pluginData->notches)
+    memset(pluginData->buf + 4 * pluginData->notches, 0,
+           4 * (notches - pluginData->notches) * sizeof(double));
+  pluginData->notches = notches;
+  for (l1 = 0; l1 < HUM_CASCADES; l1++) {
+    pluginData->notch[l1].sections = (notches > SOS_MAX_SECTIONS * l1)
+        ? notches - SOS_MAX_SECTIONS * l1 : 0;
+    if (pluginData->notch[l1].sections > SOS_MAX_SECTIONS)
+      pluginData->notch[l1].sections = SOS_MAX_SECTIONS;
+  }
+  if (nominal != pluginData->nominal || !pluginData->freq) {
+    pluginData->nominal = nominal;
+    pluginData->freq = nominal;
+    pluginData->num = 0;
+    pluginData->den = 0;
+  }
+  rbjCoefs(&pluginData->detector.section[0], RBJ_BANDPASS2, sin(pi2_f),
+           cos(pi2_f), HUM_DETECTOR_Q * (2.0 / Q_SCALE), 1.0, 1.0);
+  pluginData->detector.section[1] = pluginData->detector.section[0];
+  pluginData->detector.sections = 2;
+  pluginData->tuned = 0;
+}
+
+/* Notches on the harmonics of freq, with the Q of the q port */
+static inline void tuneFiltHum(filtHum *pluginData, double freq, float q)
+{
+  double w = 2.0 * M_PI / pluginData->rate * freq;
+  double s1 = sin(w), c1 = cos(w), s = s1, c = c1, t;
+  double q_rbj = ((q < 0.5f) ? 0.5 : q) * (2.0 / Q_SCALE);
+  uint32_t l1;
+  for (l1 = 0; l1 < pluginData->notches; l1++) {
+    rbjCoefs(&pluginData->notch[l1 / SOS_MAX_SECTIONS]
+                 .section[l1 % SOS_MAX_SECTIONS],
+             RBJ_NOTCH, s, c, q_rbj, 1.0, 1.0);
+    t = c * c1 - s * s1;
+    s = s * c1 + c * s1;
+    c = t;
+  }
+  pluginData->tuned = freq;
+}
+
+/*  Sums over a tile of the detector output y of y[n] times its second
+    difference and of y[n]^2, centred one sample back, added to *num and
+    *den; last holds the last two samples of the tile before.
+*/
+static inline void humDetect(double *last, const float *y, uint32_t len,
+    double *num, double *den)
+{
+  double y1 = last[0], y2 = last[1], n = 0, m = 0;
+  uint32_t t;
+  for (t = 0; t < len; t++) {
+    n += y1 * (y[t] - 2.0 * y1 + y2);
+    m += y1 * y1;
+    y2 = y1;
+    y1 = y[t];
+  }
+  last[0] = y1;
+  last[1] = y2;
+  *num += n;
+  *den += m;
+}
+
+/*  Move the estimate of the fundamental on by the sums of a tile of len
+    samples, see the comment at the top.  The estimate holds while the
+    detector output is below HUM_LEVEL_FLOOR.
+*/
+static inline void humTrack(filtHum *pluginData, double num, double den,
+    uint32_t len)
+{
+  double k = 1.0 - exp(-(double)len / (HUM_SMOOTH * pluginData->rate));
+  double ratio, f, lo, hi;
+  pluginData->num += k * (num / len - pluginData->num);
+  pluginData->den += k * (den / len - pluginData->den);
+  if (pluginData->den < HUM_LEVEL_FLOOR)
+    return;
+  ratio = -pluginData->num / pluginData->den;
+  if (ratio <= 0 || ratio >= 4.0)
+    return;
+  f = asin(0.5 * sqrt(ratio)) * pluginData->rate / M_PI;
+  lo = pluginData->nominal * (1.0 - HUM_DRIFT);
+  hi = pluginData->nominal * (1.0 + HUM_DRIFT);
+  pluginData->freq = (f < lo) ? lo : (f > hi) ? hi : f;
+}
+
+/*  run() of a hum instance: a tile at a time, the detector, the estimate
+    and the notches retuned to it, then the cascades, the later ones in
+    place on the output.  Idle blocks are
+    skipped, see runSilent(), and keep the estimate.
+*/
+static inline void runFiltHum(filtHum *pluginData, uint32_t sample_count)
+{
+  float controls[3] = {
+    *(pluginData->mains), *(pluginData->harmonics), *(pluginData->q)
+  };
+  int tracking = !pluginData->tracking || *(pluginData->tracking) > 0;
+  float x[HUM_TILE], y[HUM_TILE];
+  double *detector = pluginData->buf + 4 * HUM_MAX_HARMONICS;
+  double num, den;
+  float gain = *(pluginData->gain);
+  uint32_t done, len, l1, t;
+  fpuMode mode;
+  if (runSilent(pluginData->input, pluginData->output, pluginData->buf,
+                HUM_STATE, sample_count))
+    return;
+  mode = denormalsOff();
+  if (controlsChanged(&pluginData->controls, controls, 3))
+    designFiltHum(pluginData, controls);
+  if (!tracking)
+    pluginData->freq = pluginData->nominal;
+  for (done = 0; done < sample_count; done += len) {
+    len = (sample_count - done < HUM_TILE) ? sample_count - done : HUM_TILE;
+    if (pluginData->tuned != pluginData->freq)
+      tuneFiltHum(pluginData, pluginData->freq, controls[2]);
+    for (t = 0; t < len; t++)
+      x[t] = gain * pluginData->input[done + t];
+    if (tracking) {
+      num = den = 0;
+      sosRun(&pluginData->detector, detector, x, y, len);
+      humDetect(pluginData->last, y, len, &num, &den);
+      humTrack(pluginData, num, den, len);
+    }
+    sosRun(&pluginData->notch[0], pluginData->buf, x,
+           pluginData->output + done, len);
+    for (l1 = 1; l1 < HUM_CASCADES && pluginData->notch[l1].sections; l1++)
+      sosRun(&pluginData->notch[l1], pluginData->buf
+             + 4 * SOS_MAX_SECTIONS * l1, pluginData->output + done,
+             pluginData->output + done, len);
+  }
+  pluginData->denormal_flushes += flushDenormals(pluginData->buf, HUM_STATE);
+  denormalsRestore(mode);
+}
+
+#endif
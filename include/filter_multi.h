@@ -0,0 +1,230 @@
+#ifndef FILTER_MULTI_H
+#define FILTER_MULTI_H
+
+/*  Multichannel variants of the static RBJ filters.
+
+    Port layout: the channel inputs, then the channel outputs, then the
+    controls of the mono plugin (gain, freq_ofs, freq_pitch, reso_ofs and
+    dBgain_ofs where the filter has one).  The stereo variant has an extra
+    stereo_mode control last.  The coefficients are computed when the
+    controls change and all channels go through one biquadBank.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <lv2.h>
+
+#include "biquad.h"
+
+#define MULTI_DESCRIPTORS      4
+
+static const uint32_t multi_channels[MULTI_DESCRIPTORS] = { 2, 8, 16, 64 };
+
+enum {
+  STEREO_LEFT_RIGHT,
+  STEREO_MID,
+  STEREO_SIDE
+};
+
+typedef struct {
+  float *input[BIQUAD_MAX_LANES];
+  float *output[BIQUAD_MAX_LANES];
+  float *gain;
+  float *freq_ofs;
+  float *freq_pitch;
+  float *reso_ofs;
+  float *dBgain_ofs;
+  float *stereo_mode;
+  uint32_t channels;
+  int has_dBgain;
+  double rate;
+  controlCache controls;
+  biquadCoefs coefs;
+  biquadBank bank;
+  uint32_t denormal_flushes;
+} filtMulti;
+
+static LV2_Handle instantiateFiltMulti(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    LV2_Descriptor **descriptors,
+    int has_dBgain)
+{
+  filtMulti *plugin_data;
+  int l1;
+  for (l1 = 0; l1 < MULTI_DESCRIPTORS; l1++)
+    if (descriptors[l1] == descriptor)
+      break;
+  if (l1 == MULTI_DESCRIPTORS)
+    return NULL;
+  plugin_data = (filtMulti *)calloc(1, sizeof(filtMulti));
+  if (!plugin_data)
+    return NULL;
+  plugin_data->channels = multi_channels[l1];
+  plugin_data->has_dBgain = has_dBgain;
+  plugin_data->rate = s_rate;
+  return (LV2_Handle)plugin_data;
+}
+
+static void cleanupFiltMulti(LV2_Handle instance)
+{
+  free(instance);
+}
+
+static void connectPortFiltMulti(
+    LV2_Handle instance, uint32_t port, void *data)
+{
+  filtMulti *plugin = (filtMulti *)instance;
+  if (port < plugin->channels) {
+    plugin->input[port] = data;
+    return;
+  }
+  port -= plugin->channels;
+  if (port < plugin->channels) {
+    plugin->output[port] = data;
+    return;
+  }
+  port -= plugin->channels;
+  if (!plugin->has_dBgain && port >= 4)
+    port++;
+  switch(port){
+    case 0: plugin->gain = data;        break;
+    case 1: plugin->freq_ofs = data;    break;
+    case 2: plugin->freq_pitch = data;  break;
+    case 3: plugin->reso_ofs = data;    break;
+    case 4: plugin->dBgain_ofs = data;  break;
+    case 5: plugin->stereo_mode = data; break;
+  }
+}
+
+static void activateFiltMulti(LV2_Handle instance)
+{
+  filtMulti *plugin_data = (filtMulti *)instance;
+  biquadBankReset(&plugin_data->bank);
+}
+
+/*  All channels are idle when every input is silent and every state has
+    decayed, see runSilent().
+*/
+static inline int silentFiltMulti(
+    filtMulti *pluginData, uint32_t sample_count)
+{
+  biquadBank *bank = &pluginData->bank;
+  uint32_t channels = pluginData->channels;
+  uint32_t l1;
+  for (l1 = 0; l1 < channels; l1++)
+    if (!blockZero(pluginData->input[l1], sample_count))
+      return 0;
+  if (!stateDecayed(bank->x1, channels) || !stateDecayed(bank->x2, channels)
+      || !stateDecayed(bank->y1, channels)
+      || !stateDecayed(bank->y2, channels))
+    return 0;
+  biquadBankReset(bank);
+  for (l1 = 0; l1 < channels; l1++)
+    memset(pluginData->output[l1], 0, sample_count * sizeof(float));
+  return 1;
+}
+
+/*  Left/right processing with coefficients that reduce to a gain and a
+    state that has settled on it, see biquadRunFixed(); nonzero if the
+    block was handled as a copy, scale or zero fill.
+*/
+static inline int gainFiltMulti(
+    filtMulti *pluginData, uint32_t sample_count, int mode)
+{
+  biquadBank *bank = &pluginData->bank;
+  uint32_t channels = pluginData->channels;
+  uint32_t l1;
+  double gain, buf[4];
+  if (mode != STEREO_LEFT_RIGHT || !biquadGain(&pluginData->coefs, &gain))
+    return 0;
+  for (l1 = 0; l1 < channels; l1++)
+    if (!biquadStateAtGain(bank->x1[l1], bank->x2[l1], bank->y1[l1],
+                           bank->y2[l1], gain))
+      return 0;
+  for (l1 = 0; l1 < channels; l1++) {
+    buf[0] = bank->x1[l1];
+    buf[1] = bank->x2[l1];
+    buf[2] = bank->y1[l1];
+    buf[3] = bank->y2[l1];
+    biquadRunGain(gain, buf, pluginData->input[l1], pluginData->output[l1],
+                  sample_count);
+    bank->x1[l1] = buf[0];
+    bank->x2[l1] = buf[1];
+    bank->y1[l1] = buf[2];
+    bank->y2[l1] = buf[3];
+  }
+  return 1;
+}
+
+static inline void runFiltMulti(
+    filtMulti *pluginData, uint32_t sample_count, int type)
+{
+  uint32_t l1, l2, l3, len;
+  double mid, side;
+  biquadBank *bank = &pluginData->bank;
+  uint32_t channels = pluginData->channels;
+  int mode = (pluginData->stereo_mode)
+      ? (int)*(pluginData->stereo_mode) : STEREO_LEFT_RIGHT;
+  fpuMode fpu_mode;
+  float controls[CONTROLS_MAX] = {
+    *(pluginData->gain), *(pluginData->freq_ofs), *(pluginData->freq_pitch),
+    *(pluginData->reso_ofs),
+    (pluginData->dBgain_ofs) ? *(pluginData->dBgain_ofs) : 0
+  };
+  if (silentFiltMulti(pluginData, sample_count))
+    return;
+  fpu_mode = denormalsOff();
+  if (controlsChanged(&pluginData->controls, controls, CONTROLS_MAX))
+    rbjControlCoefs(&pluginData->coefs, type, pluginData->rate,
+                    controls[0], controls[1], controls[2], controls[3],
+                    controls[4]);
+  if (gainFiltMulti(pluginData, sample_count, mode)) {
+    denormalsRestore(fpu_mode);
+    return;
+  }
+  for (l1 = 0; l1 < sample_count; l1 += len) {
+    len = sample_count - l1;
+    if (len > BIQUAD_TILE)
+      len = BIQUAD_TILE;
+    if (mode == STEREO_LEFT_RIGHT) {
+      for (l2 = 0; l2 < channels; l2++) {
+        const float *input = pluginData->input[l2] + l1;
+        for (l3 = 0; l3 < len; l3++)
+          bank->in[l3][l2] = input[l3];
+      }
+    }
+    else {
+      for (l3 = 0; l3 < len; l3++) {
+        double left = pluginData->input[0][l1 + l3];
+        double right = pluginData->input[1][l1 + l3];
+        bank->in[l3][0] = 0.5 * (left + right);
+        bank->in[l3][1] = 0.5 * (left - right);
+      }
+    }
+    biquadBankRun(&pluginData->coefs, bank, channels, len);
+    if (mode == STEREO_LEFT_RIGHT) {
+      for (l2 = 0; l2 < channels; l2++) {
+        float *output = pluginData->output[l2] + l1;
+        for (l3 = 0; l3 < len; l3++)
+          output[l3] = bank->out[l3][l2];
+      }
+    }
+    else {
+      for (l3 = 0; l3 < len; l3++) {
+        mid = (mode == STEREO_MID) ? bank->out[l3][0] : bank->in[l3][0];
+        side = (mode == STEREO_SIDE) ? bank->out[l3][1] : bank->in[l3][1];
+        pluginData->output[0][l1 + l3] = mid + side;
+        pluginData->output[1][l1 + l3] = mid - side;
+      }
+    }
+  }
+  pluginData->denormal_flushes +=
+      flushDenormals(bank->x1, channels)
+      | flushDenormals(bank->x2, channels)
+      | flushDenormals(bank->y1, channels)
+      | flushDenormals(bank->y2, channels);
+  denormalsRestore(fpu_mode);
+}
+
+#endif
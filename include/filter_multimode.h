@@ -0,0 +1,206 @@
+#ifndef FILTER_MULTIMODE_H
+#define FILTER_MULTIMODE_H
+
+/*  Multimode filter: the lowpass, highpass, bandpass and notch responses
+    of one state variable core (see svf.h), with the cutoff and resonance
+    of the RBJ plugins, plus a morph output that sweeps continuously from
+    lowpass (morph 0) through bandpass (0.5) to highpass (1).  The
+    bandpass has 0 dB peak gain as bandpass2.
+
+    Port layout: the input, the five outputs, then gain, freq_ofs,
+    freq_pitch, reso_ofs and morph.  The _cv plugin adds a CV input after
+    freq_pitch, reso_ofs and morph each.  Outputs that are not connected
+    are not written.
+*/
+
+#include <stdlib.h>
+#include <lv2.h>
+
+#include "svf.h"
+
+enum {
+  MULTIMODE_LOWPASS,
+  MULTIMODE_HIGHPASS,
+  MULTIMODE_BANDPASS,
+  MULTIMODE_NOTCH,
+  MULTIMODE_MORPH,
+  MULTIMODE_OUTPUTS
+};
+
+/* morph_in takes the dBgain_in slot of the CV kernels */
+#define CV_MORPH               CV_DBGAIN
+
+typedef struct {
+  float *input;
+  float *output[MULTIMODE_OUTPUTS];
+  float *gain;
+  float *freq_ofs;
+  float *freq_pitch;
+  float *freq_in;
+  float *reso_ofs;
+  float *reso_in;
+  float *morph;
+  float *morph_in;
+  int has_cv;
+  coefTable *table;
+  double rate, state[2];
+  uint32_t denormal_flushes;
+} filtMultimode;
+
+static LV2_Handle instantiateFiltMultimode(double s_rate, int has_cv)
+{
+  filtMultimode *plugin_data =
+      (filtMultimode *)calloc(1, sizeof(filtMultimode));
+  if (!plugin_data)
+    return NULL;
+  plugin_data->has_cv = has_cv;
+  plugin_data->rate = s_rate;
+  plugin_data->table = coefTableAcquire(s_rate);
+  if (!plugin_data->table) {
+    free(plugin_data);
+    return NULL;
+  }
+  return (LV2_Handle)plugin_data;
+}
+
+static void cleanupFiltMultimode(LV2_Handle instance)
+{
+  coefTableRelease(((filtMultimode *)instance)->table);
+  free(instance);
+}
+
+static void connectPortFiltMultimode(
+    LV2_Handle instance, uint32_t port, void *data)
+{
+  static const uint32_t static_ports[] = { 0, 1, 2, 4, 6 };
+  filtMultimode *plugin = (filtMultimode *)instance;
+  if (port == 0) {
+    plugin->input = data;
+    return;
+  }
+  port--;
+  if (port < MULTIMODE_OUTPUTS) {
+    plugin->output[port] = data;
+    return;
+  }
+  port -= MULTIMODE_OUTPUTS;
+  if (!plugin->has_cv) {
+    if (port >= sizeof(static_ports) / sizeof(static_ports[0]))
+      return;
+    port = static_ports[port];
+  }
+  switch(port){
+    case 0: plugin->gain = data;        break;
+    case 1: plugin->freq_ofs = data;    break;
+    case 2: plugin->freq_pitch = data;  break;
+    case 3: plugin->freq_in = data;     break;
+    case 4: plugin->reso_ofs = data;    break;
+    case 5: plugin->reso_in = data;     break;
+    case 6: plugin->morph = data;       break;
+    case 7: plugin->morph_in = data;    break;
+  }
+}
+
+static void activateFiltMultimode(LV2_Handle instance)
+{
+  filtMultimode *plugin_data = (filtMultimode *)instance;
+  plugin_data->state[0] = plugin_data->state[1] = 0;
+}
+
+/*  Idle blocks are skipped as in runSilent(), for every connected
+    output.
+*/
+static inline int silentFiltMultimode(
+    filtMultimode *pluginData, uint32_t sample_count)
+{
+  int l1;
+  if (!blockZero(pluginData->input, sample_count)
+      || !stateDecayed(pluginData->state, 2))
+    return 0;
+  pluginData->state[0] = pluginData->state[1] = 0;
+  for (l1 = 0; l1 < MULTIMODE_OUTPUTS; l1++)
+    if (pluginData->output[l1])
+      memset(pluginData->output[l1], 0, sample_count * sizeof(float));
+  return 1;
+}
+
+/*  run() for one set of active CV inputs, see CV_KERNELS.  The
+    coefficients are those of the RBJ_BANDPASS2 _svf filter, whose k
+    turns the band output into the 0 dB bandpass; highpass and notch
+    follow from the input minus the other responses.  conn is expected
+    to be a constant.
+*/
+static inline void runFiltMultimodeConn(
+    filtMultimode *pluginData, uint32_t sample_count, int conn)
+{
+  const int coef_conn = conn & (CV_FREQ | CV_RESO);
+  const float *input = pluginData->input;
+  float *lowpass = pluginData->output[MULTIMODE_LOWPASS];
+  float *highpass = pluginData->output[MULTIMODE_HIGHPASS];
+  float *bandpass = pluginData->output[MULTIMODE_BANDPASS];
+  float *notch = pluginData->output[MULTIMODE_NOTCH];
+  float *morph_out = pluginData->output[MULTIMODE_MORPH];
+  double *state = pluginData->state;
+  double gain = *(pluginData->gain);
+  double morph0 = *(pluginData->morph);
+  double v1, v2, low, band, high, morph;
+  uint32_t l1, l2, len;
+  svfCoefs c;
+  rbjCV cv;
+  if (silentFiltMultimode(pluginData, sample_count))
+    return;
+  cv.table = pluginData->table;
+  cv.f0 = *(pluginData->freq_ofs);
+  cv.freq_pitch = (*(pluginData->freq_pitch) > 0)
+      ? 1.0 + *(pluginData->freq_pitch) / 2.0
+      : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
+  cv.q0 = *(pluginData->reso_ofs);
+  cv.dBgain0 = 0;
+  cv.gain = 1;
+  cv.freq_in = pluginData->freq_in;
+  cv.reso_in = pluginData->reso_in;
+  cv.dBgain_in = NULL;
+  for (l1 = 0; l1 < sample_count; l1 += len) {
+    len = (coef_conn)
+        ? cvRunLength(coef_conn, cv.freq_in, cv.reso_in, NULL, l1,
+                      sample_count)
+        : sample_count;
+    svfCVCoefs(&c, RBJ_BANDPASS2, coef_conn, &cv, l1);
+    for (l2 = l1; l2 < l1 + len; l2++) {
+      svfStep(&c, state, input[l2], &v1, &v2);
+      low = gain * v2;
+      band = gain * c.k * v1;
+      high = gain * input[l2] - band - low;
+      morph = (conn & CV_MORPH)
+          ? morph0 + pluginData->morph_in[l2] : morph0;
+      if (morph < 0)
+        morph = 0;
+      if (morph > 1)
+        morph = 1;
+      if (lowpass)
+        lowpass[l2] = low;
+      if (highpass)
+        highpass[l2] = high;
+      if (bandpass)
+        bandpass[l2] = band;
+      if (notch)
+        notch[l2] = low + high;
+      if (morph_out)
+        morph_out[l2] = (morph < 0.5)
+            ? low + 2.0 * morph * (band - low)
+            : band + (2.0 * morph - 1.0) * (high - band);
+    }
+  }
+  pluginData->denormal_flushes += flushDenormals(state, 2);
+}
+
+/* run() of a multimode instance, dispatching to kernels as the _cv plugins */
+static inline void runFiltMultimode(filtMultimode *pluginData,
+    uint32_t sample_count, const cvKernel *kernels)
+{
+  int conn = cvActiveConnections(pluginData->freq_in, pluginData->reso_in,
+                                 pluginData->morph_in, sample_count);
+  kernels[conn]((LV2_Handle)pluginData, sample_count);
+}
+
+#endif
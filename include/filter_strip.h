@@ -0,0 +1,108 @@
+#ifndef FILTER_STRIP_H
+#define FILTER_STRIP_H
+
+/*  Channel strip: a low shelf, STRIP_PEAKS peaking bands and a high shelf
+    in series, with the formulas of the low_shelf, peak_eq and high_shelf
+    plugins, in one pass over the audio.
+
+    Port layout: the input, the output, gain, then the frequency,
+    resonance and dB gain of each band from the low shelf up, then
+    enabled.
+
+    A band recomputes its coefficients only when its own controls change;
+    the bands run in one pass through sosBandsRun(), which leaves out
+    those at 0 dB.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <lv2.h>
+
+#include "biquad.h"
+#include "sos.h"
+
+#define STRIP_PEAKS            3
+#define STRIP_BANDS            (STRIP_PEAKS + 2)
+#define STRIP_CONTROLS         3
+
+typedef struct {
+  float *input;
+  float *output;
+  float *gain;
+  float *band[STRIP_BANDS][STRIP_CONTROLS];
+  controlCache controls[STRIP_BANDS];
+  biquadCoefs coefs[STRIP_BANDS];
+  double rate, buf[4 * STRIP_BANDS];
+  uint32_t denormal_flushes;
+  bypassFade bypass;
+} filtStrip;
+
+static inline int stripType(uint32_t band)
+{
+  if (band == 0)
+    return RBJ_LOW_SHELF;
+  return (band == STRIP_BANDS - 1) ? RBJ_HIGH_SHELF : RBJ_PEAK_EQ;
+}
+
+static LV2_Handle instantiateFiltStrip(double s_rate)
+{
+  filtStrip *plugin_data = (filtStrip *)calloc(1, sizeof(filtStrip));
+  if (!plugin_data)
+    return NULL;
+  plugin_data->rate = s_rate;
+  bypassInit(&plugin_data->bypass);
+  return (LV2_Handle)plugin_data;
+}
+
+static void cleanupFiltStrip(LV2_Handle instance)
+{
+  free(instance);
+}
+
+static void connectPortFiltStrip(
+    LV2_Handle instance, uint32_t port, void *data)
+{
+  filtStrip *plugin = (filtStrip *)instance;
+  switch(port){
+    case 0: plugin->input = data;       return;
+    case 1: plugin->output = data;      return;
+    case 2: plugin->gain = data;        return;
+  }
+  port -= 3;
+  if (port < STRIP_BANDS * STRIP_CONTROLS)
+    plugin->band[port / STRIP_CONTROLS][port % STRIP_CONTROLS] = data;
+  else if (port == STRIP_BANDS * STRIP_CONTROLS)
+    plugin->bypass.enabled = data;
+}
+
+static void activateFiltStrip(LV2_Handle instance)
+{
+  filtStrip *plugin_data = (filtStrip *)instance;
+  memset(plugin_data->buf, 0, sizeof(plugin_data->buf));
+}
+
+static inline void runFiltStrip(filtStrip *pluginData, uint32_t sample_count)
+{
+  double *buf = pluginData->buf;
+  uint32_t l1;
+  fpuMode mode;
+  if (runSilent(pluginData->input, pluginData->output, buf,
+                4 * STRIP_BANDS, sample_count))
+    return;
+  mode = denormalsOff();
+  for (l1 = 0; l1 < STRIP_BANDS; l1++) {
+    float **port = pluginData->band[l1];
+    float controls[STRIP_CONTROLS] = { *port[0], *port[1], *port[2] };
+    if (controlsChanged(&pluginData->controls[l1], controls,
+                        STRIP_CONTROLS))
+      rbjControlCoefs(&pluginData->coefs[l1], stripType(l1),
+                      pluginData->rate, 1.0, controls[0], 0, controls[1],
+                      controls[2]);
+  }
+  sosBandsRun(pluginData->coefs, buf, STRIP_BANDS, *(pluginData->gain),
+              pluginData->input, pluginData->output, sample_count);
+  pluginData->denormal_flushes += flushDenormals(buf, 4 * STRIP_BANDS);
+  denormalsRestore(mode);
+}
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef FILTER_SVF_H
+#define FILTER_SVF_H
+
+/*  _svf variants of the RBJ filters, see svf.h.
+
+    Port layout: the ports of the _cv plugin without mod_rate, which the
+    state variable filter does not need, and the lv2:enabled port last.
+*/
+
+#include <stdlib.h>
+#include <lv2.h>
+
+#include "svf.h"
+
+typedef struct {
+  float *input;
+  float *output;
+  float *gain;
+  float *freq_ofs;
+  float *freq_pitch;
+  float *freq_in;
+  float *reso_ofs;
+  float *reso_in;
+  float *dBgain_ofs;
+  float *dBgain_in;
+  int has_dBgain;
+  coefTable *table;
+  double rate, state[2];
+  uint32_t denormal_flushes;
+  bypassFade bypass;
+} filtSVF;
+
+static LV2_Handle instantiateFiltSVF(double s_rate, int has_dBgain)
+{
+  filtSVF *plugin_data = (filtSVF *)calloc(1, sizeof(filtSVF));
+  if (!plugin_data)
+    return NULL;
+  plugin_data->has_dBgain = has_dBgain;
+  plugin_data->rate = s_rate;
+  bypassInit(&plugin_data->bypass);
+  plugin_data->table = coefTableAcquire(s_rate);
+  if (!plugin_data->table) {
+    free(plugin_data);
+    return NULL;
+  }
+  return (LV2_Handle)plugin_data;
+}
+
+static void cleanupFiltSVF(LV2_Handle instance)
+{
+  coefTableRelease(((filtSVF *)instance)->table);
+  free(instance);
+}
+
+static void connectPortFiltSVF(
+    LV2_Handle instance, uint32_t port, void *data)
+{
+  filtSVF *plugin = (filtSVF *)instance;
+  if (!plugin->has_dBgain && port >= 8)
+    port += 2;
+  switch(port){
+    case 0:  plugin->input = data;          break;
+    case 1:  plugin->output = data;         break;
+    case 2:  plugin->gain = data;           break;
+    case 3:  plugin->freq_ofs = data;       break;
+    case 4:  plugin->freq_pitch = data;     break;
+    case 5:  plugin->freq_in = data;        break;
+    case 6:  plugin->reso_ofs = data;       break;
+    case 7:  plugin->reso_in = data;        break;
+    case 8:  plugin->dBgain_ofs = data;     break;
+    case 9:  plugin->dBgain_in = data;      break;
+    case 10: plugin->bypass.enabled = data; break;
+  }
+}
+
+static void activateFiltSVF(LV2_Handle instance)
+{
+  filtSVF *plugin_data = (filtSVF *)instance;
+  plugin_data->state[0] = plugin_data->state[1] = 0;
+}
+
+/*  run() for one set of connected CV inputs, see CV_KERNELS.  type and
+    conn are expected to be constants.
+*/
+static inline void runFiltSVFConn(
+    filtSVF *pluginData, uint32_t sample_count, int type, int conn)
+{
+  rbjCV cv;
+  cv.table = pluginData->table;
+  cv.f0 = *(pluginData->freq_ofs);
+  cv.freq_pitch = (*(pluginData->freq_pitch) > 0)
+      ? 1.0 + *(pluginData->freq_pitch) / 2.0
+      : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
+  cv.q0 = *(pluginData->reso_ofs);
+  cv.dBgain0 = (pluginData->dBgain_ofs) ? *(pluginData->dBgain_ofs) : 0;
+  cv.gain = *(pluginData->gain);
+  cv.freq_in = pluginData->freq_in;
+  cv.reso_in = pluginData->reso_in;
+  cv.dBgain_in = pluginData->dBgain_in;
+  svfCVRun(&cv, type, conn, pluginData->state, pluginData->input,
+           pluginData->output, sample_count);
+  pluginData->denormal_flushes += flushDenormals(pluginData->state, 2);
+}
+
+/* run() of an _svf instance, dispatching to kernels as the _cv plugins */
+static inline void runFiltSVF(filtSVF *pluginData, uint32_t sample_count,
+    const cvKernel *kernels)
+{
+  uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                               pluginData->output, sample_count);
+  int conn;
+  if (count) {
+    conn = cvActiveConnections(pluginData->freq_in, pluginData->reso_in,
+                               pluginData->dBgain_in, count);
+    kernels[conn]((LV2_Handle)pluginData, count);
+  }
+  bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+            sample_count);
+}
+
+#endif
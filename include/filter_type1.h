@@ -1,6 +1,10 @@
 #ifndef FILTER_TYPE1_H
 #define FILTER_TYPE1_H
 
+#include "filter_voices.h"
+#include "modsource.h"
+#include "paramevents.h"
+
 typedef struct {
   float *input;
   float *output;
@@ -8,7 +12,13 @@ typedef struct {
   float *freq_ofs;
   float *freq_pitch;
   float *reso_ofs;
-  double rate, buf[2];
+  float *poles;
+  paramEvents params;
+  controlCache controls;
+  double rate, buf[4];
+  double f, fa, fb;
+  uint32_t denormal_flushes;
+  bypassFade bypass;
 } filtType1;
 
 typedef struct {
@@ -20,7 +30,33 @@ typedef struct {
   float *reso_ofs;
   float *freq_in;
   float *reso_in;
-  double rate, buf[2];
+  float *mod_rate;
+  float *poles;
+  modSource mod;
+  double rate, buf[4];
+  double coef_f, coef_q;
+  int coefs_valid;
+  uint32_t denormal_flushes;
+  bypassFade bypass;
 } filtType1_cv;
 
+/*  Voice bank of the Kellett filter, laid out as filtVoices: f and q
+    ramp between two decimated updates, and the tiles hold the values used
+    for each sample of the current tile.  q_min and q_max are the reso
+    clamp of each voice, which depends on whether its reso_in is connected.
+*/
+typedef struct {
+  filtVoicePorts ports;
+  double f[VOICES_MAX], q[VOICES_MAX];
+  double f1[VOICES_MAX], q1[VOICES_MAX];
+  double f_step[VOICES_MAX], q_step[VOICES_MAX];
+  double q_min[VOICES_MAX], q_max[VOICES_MAX];
+  double buf0[VOICES_MAX], buf1[VOICES_MAX];
+  double f_tile[VOICES_TILE][VOICES_MAX], q_tile[VOICES_TILE][VOICES_MAX];
+  double freq[VOICES_TILE][VOICES_MAX], reso[VOICES_TILE][VOICES_MAX];
+  double in[VOICES_TILE][VOICES_MAX], out[VOICES_TILE][VOICES_MAX];
+  int coefs_valid;
+  uint32_t denormal_flushes;
+} filtType1_voices;
+
 #endif
@@ -1,6 +1,11 @@
 #ifndef FILTER_TYPE2_H
 #define FILTER_TYPE2_H
 
+#include "biquad.h"
+#include "sos.h"
+#include "modsource.h"
+#include "paramevents.h"
+
 typedef struct {
   float *input;
   float *output;
@@ -8,9 +13,88 @@ typedef struct {
   float *freq_ofs;
   float *freq_pitch;
   float *reso_ofs;
-  double rate, buf[4];
+  float *sections;
+  float *response;
+  paramEvents params;
+  controlCache controls;
+  biquadCoefs coefs;
+  sosCascade sos;
+  double rate, buf[4 * SOS_MAX_SECTIONS];
+  uint32_t denormal_flushes;
+  bypassFade bypass;
 } filtType2;
 
+/*  len samples of a static instance from offset on, with the frequency
+    and resonance of values, see runFiltType2().
+*/
+static inline void runFiltType2Span(filtType2 *pluginData, uint32_t offset,
+    uint32_t len, int type, const float *values)
+{
+  fpuMode mode;
+  double iv_sin, iv_cos, q, A;
+  sosCascade *sos = &pluginData->sos;
+  const float *input = pluginData->input + offset;
+  float *output = pluginData->output + offset;
+  float controls[CONTROLS_MAX] = {
+    *(pluginData->gain), values[PARAM_FREQ], *(pluginData->freq_pitch),
+    values[PARAM_RESO], 0
+  };
+  if (runSilent(input, output, pluginData->buf, 4 * sos->sections, len))
+    return;
+  mode = denormalsOff();
+  if (sos->sections == 1 && sos->response == SOS_RESONANT) {
+    if (controlsChanged(&pluginData->controls, controls, 4))
+      rbjControlCoefs(&pluginData->coefs, type, pluginData->rate,
+                      controls[0], controls[1], controls[2], controls[3],
+                      controls[4]);
+    biquadRunFixed(&pluginData->coefs, pluginData->buf, input, output, len);
+  }
+  else {
+    if (controlsChanged(&pluginData->controls, controls, 4)) {
+      rbjControlParams(type, pluginData->rate, controls[1], controls[2],
+                       controls[3], controls[4], &iv_sin, &iv_cos, &q, &A);
+      sosDesign(sos, type, iv_sin, iv_cos, q, controls[0]);
+    }
+    sosRun(sos, pluginData->buf, input, output, len);
+  }
+  pluginData->denormal_flushes +=
+      flushDenormals(pluginData->buf, 4 * sos->sections);
+  denormalsRestore(mode);
+}
+
+/*  run() of a static instance; the coefficients are only recomputed when
+    the controls change and idle blocks are skipped, see runSilent().
+    With more than a plain biquad selected on the sections and response
+    ports the filter runs as a cascade, see sos.h.  The block is split at
+    the parameter events, see paramevents.h; with sample_count 0, for a
+    bypassed instance, the events are only taken.  type is expected to be
+    a constant.
+*/
+static inline void runFiltType2(
+    filtType2 *pluginData, uint32_t sample_count, int type)
+{
+  float *ports[PARAM_COUNT] = {
+    pluginData->freq_ofs, pluginData->reso_ofs, NULL
+  };
+  float values[PARAM_COUNT], value;
+  uint32_t done = 0, at;
+  int index;
+  if (sosSelect(&pluginData->sos, pluginData->buf,
+                sosSections(pluginData->sections),
+                sosResponse(pluginData->response)))
+    pluginData->controls.valid = 0;
+  paramBegin(&pluginData->params, ports, values);
+  do {
+    at = paramNext(&pluginData->params, sample_count, &index, &value);
+    if (at > done) {
+      runFiltType2Span(pluginData, done, at - done, type, values);
+      done = at;
+    }
+    if (index >= 0)
+      paramSet(&pluginData->params, ports, values, index, value);
+  } while (index >= 0);
+}
+
 typedef struct {
   float *input;
   float *output;
@@ -19,8 +103,69 @@ typedef struct {
   float *freq_pitch;
   float *reso_ofs;
   float *freq_in;
-  float *reso_in; 
-  double rate, buf[4];
+  float *reso_in;
+  float *mod_rate;
+  float *sections;
+  float *response;
+  modSource mod;
+  coefTable *table;
+  biquadCoefs coefs;
+  int coefs_valid;
+  sosCascade sos;
+  double rate, buf[4 * SOS_MAX_SECTIONS];
+  uint32_t denormal_flushes;
+  bypassFade bypass;
 } filtType2_cv;
 
+/*  run() of a _cv instance for one set of connected CV inputs, see
+    CV_KERNELS, as a plain biquad or a cascade as runFiltType2(), with
+    the offsets moved by the internal source if one is selected, see
+    modCVRun().  type and conn are expected to be constants.
+*/
+static inline void runFiltType2CV(
+    filtType2_cv *pluginData, uint32_t sample_count, int type, int conn)
+{
+  rbjCV cv;
+  sosCascade *sos = &pluginData->sos;
+  float freq_pitch =
+      (*(pluginData->freq_pitch) > 0)
+          ? 1.0 + *(pluginData->freq_pitch) / 2.0
+          : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
+  uint32_t mod_step = (*(pluginData->mod_rate) > 1)
+      ? (uint32_t)*(pluginData->mod_rate) : 1;
+  if (mod_step > MOD_RATE_MAX)
+    mod_step = MOD_RATE_MAX;
+  cv.table = pluginData->table;
+  cv.f0 = *(pluginData->freq_ofs);
+  cv.freq_pitch = freq_pitch;
+  cv.q0 = *(pluginData->reso_ofs);
+  cv.dBgain0 = 0;
+  cv.gain = *(pluginData->gain);
+  cv.freq_in = pluginData->freq_in;
+  cv.reso_in = pluginData->reso_in;
+  cv.dBgain_in = NULL;
+  if (sosSelect(sos, pluginData->buf, sosSections(pluginData->sections),
+                sosResponse(pluginData->response)))
+    pluginData->coefs_valid = 0;
+  if (modSourceBegin(&pluginData->mod)) {
+    modCVRun(&pluginData->mod, &cv, type, conn,
+             (sos->sections == 1 && sos->response == SOS_RESONANT)
+                 ? NULL : sos,
+             &pluginData->coefs, &pluginData->coefs_valid, pluginData->buf,
+             pluginData->input, pluginData->output, sample_count, mod_step);
+  }
+  else if (sos->sections == 1 && sos->response == SOS_RESONANT) {
+    rbjCVRun(&cv, type, conn, &pluginData->coefs, &pluginData->coefs_valid,
+             pluginData->buf, pluginData->input, pluginData->output,
+             sample_count, mod_step);
+  }
+  else {
+    sosCVRun(&cv, type, conn, sos, &pluginData->coefs_valid,
+             pluginData->buf, pluginData->input, pluginData->output,
+             sample_count, mod_step);
+  }
+  pluginData->denormal_flushes +=
+      flushDenormals(pluginData->buf, 4 * sos->sections);
+}
+
 #endif
@@ -1,6 +1,10 @@
 #ifndef FILTER_TYPE3_H
 #define FILTER_TYPE3_H
 
+#include "biquad.h"
+#include "modsource.h"
+#include "paramevents.h"
+
 typedef struct {
   float *input;
   float *output;
@@ -9,9 +13,65 @@ typedef struct {
   float *freq_pitch;
   float *reso_ofs;
   float *dBgain_ofs;
+  paramEvents params;
+  controlCache controls;
+  biquadCoefs coefs;
   double rate, buf[4];
+  uint32_t denormal_flushes;
+  bypassFade bypass;
 } filtType3;
 
+/*  len samples of a static instance from offset on, with the frequency,
+    resonance and dB gain of values, see runFiltType3().
+*/
+static inline void runFiltType3Span(filtType3 *pluginData, uint32_t offset,
+    uint32_t len, int type, const float *values)
+{
+  fpuMode mode;
+  const float *input = pluginData->input + offset;
+  float *output = pluginData->output + offset;
+  float controls[CONTROLS_MAX] = {
+    *(pluginData->gain), values[PARAM_FREQ], *(pluginData->freq_pitch),
+    values[PARAM_RESO], values[PARAM_DBGAIN]
+  };
+  if (runSilent(input, output, pluginData->buf, 4, len))
+    return;
+  mode = denormalsOff();
+  if (controlsChanged(&pluginData->controls, controls, 5))
+    rbjControlCoefs(&pluginData->coefs, type, pluginData->rate,
+                    controls[0], controls[1], controls[2], controls[3],
+                    controls[4]);
+  biquadRunFixed(&pluginData->coefs, pluginData->buf, input, output, len);
+  pluginData->denormal_flushes += flushDenormals(pluginData->buf, 4);
+  denormalsRestore(mode);
+}
+
+/*  run() of a static instance; the coefficients are only recomputed when
+    the controls change and idle blocks are skipped, see runSilent().
+    The block is split at the parameter events, see paramevents.h; with
+    sample_count 0, for a bypassed instance, the events are only taken.
+    type is expected to be a constant.
+*/
+static inline void runFiltType3(
+    filtType3 *pluginData, uint32_t sample_count, int type)
+{
+  float *ports[PARAM_COUNT] = {
+    pluginData->freq_ofs, pluginData->reso_ofs, pluginData->dBgain_ofs
+  };
+  float values[PARAM_COUNT], value;
+  uint32_t done = 0, at;
+  int index;
+  paramBegin(&pluginData->params, ports, values);
+  do {
+    at = paramNext(&pluginData->params, sample_count, &index, &value);
+    if (at > done) {
+      runFiltType3Span(pluginData, done, at - done, type, values);
+      done = at;
+    }
+    if (index >= 0)
+      paramSet(&pluginData->params, ports, values, index, value);
+  } while (index >= 0);
+}
 
 typedef struct {
   float *input;
@@ -24,7 +84,51 @@ typedef struct {
   float *freq_in;
   float *reso_in;
   float *dBgain_in;
+  float *mod_rate;
+  modSource mod;
+  coefTable *table;
+  biquadCoefs coefs;
+  int coefs_valid;
   double rate, buf[4];
+  uint32_t denormal_flushes;
+  bypassFade bypass;
 } filtType3_cv;
 
+/*  run() of a _cv instance for one set of connected CV inputs, see
+    CV_KERNELS, with the offsets moved by the internal source if one is
+    selected, see modCVRun().  type and conn are expected to be
+    constants.
+*/
+static inline void runFiltType3CV(
+    filtType3_cv *pluginData, uint32_t sample_count, int type, int conn)
+{
+  rbjCV cv;
+  float freq_pitch =
+      (*(pluginData->freq_pitch) > 0)
+          ? 1.0 + *(pluginData->freq_pitch) / 2.0
+          : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
+  uint32_t mod_step = (*(pluginData->mod_rate) > 1)
+      ? (uint32_t)*(pluginData->mod_rate) : 1;
+  if (mod_step > MOD_RATE_MAX)
+    mod_step = MOD_RATE_MAX;
+  cv.table = pluginData->table;
+  cv.f0 = *(pluginData->freq_ofs);
+  cv.freq_pitch = freq_pitch;
+  cv.q0 = *(pluginData->reso_ofs);
+  cv.dBgain0 = *(pluginData->dBgain_ofs);
+  cv.gain = *(pluginData->gain);
+  cv.freq_in = pluginData->freq_in;
+  cv.reso_in = pluginData->reso_in;
+  cv.dBgain_in = pluginData->dBgain_in;
+  if (modSourceBegin(&pluginData->mod))
+    modCVRun(&pluginData->mod, &cv, type, conn, NULL, &pluginData->coefs,
+             &pluginData->coefs_valid, pluginData->buf, pluginData->input,
+             pluginData->output, sample_count, mod_step);
+  else
+    rbjCVRun(&cv, type, conn, &pluginData->coefs,
+             &pluginData->coefs_valid, pluginData->buf, pluginData->input,
+             pluginData->output, sample_count, mod_step);
+  pluginData->denormal_flushes += flushDenormals(pluginData->buf, 4);
+}
+
 #endif
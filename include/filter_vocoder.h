@@ -0,0 +1,300 @@
+#ifndef FILTER_VOCODER_H
+#define FILTER_VOCODER_H
+
+/*  Channel vocoder: the modulator and the carrier each go through a bank
+    of bandpass2 filters (constant 0 dB peak gain) at log spaced centre
+    frequencies from VOCODER_FREQ_LO to VOCODER_FREQ_HI, each band one
+    band spacing wide.  An envelope follower on every modulator band sets
+    the gain of the same carrier band, and the carrier bands are summed.
+
+    Port layout: the modulator input, the carrier input, the output, then
+    gain, attack and release.
+
+    Both banks are kept as structure-of-arrays lanes, one per band, and
+    every step of the recursion runs across all bands at once.  The
+    bandpass2 numerator is b0 * (x - x2), so a bank shares one input
+    history, and each lane keeps only the last two outputs divided by b0,
+    u1 and u2, which takes b0 out of the recursion.  The followers run at
+    control rate: once per tile of VOCODER_TILE samples they take the RMS
+    of the modulator band over the tile, and the carrier gains ramp to
+    the new envelope across the tile.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <lv2.h>
+
+#include "biquad.h"
+
+#define VOCODER_DESCRIPTORS    2
+#define VOCODER_MAX_BANDS     32
+#define VOCODER_TILE          16
+#define VOCODER_LANES          8
+#define VOCODER_VECS           (VOCODER_LANES / 2)
+#define VOCODER_FREQ_LO      100
+#define VOCODER_FREQ_HI     8000
+
+static const uint32_t vocoder_bands[VOCODER_DESCRIPTORS] = { 16, 32 };
+
+typedef struct {
+  float *modulator;
+  float *carrier;
+  float *output;
+  float *gain;
+  float *attack;
+  float *release;
+  uint32_t bands;
+  double rate;
+  double b0[VOCODER_MAX_BANDS];
+  double a1[VOCODER_MAX_BANDS];
+  double a2[VOCODER_MAX_BANDS];
+  double mod_x[2], car_x[2];
+  double mod_u1[VOCODER_MAX_BANDS], mod_u2[VOCODER_MAX_BANDS];
+  double car_u1[VOCODER_MAX_BANDS], car_u2[VOCODER_MAX_BANDS];
+  double env[VOCODER_MAX_BANDS];
+  uint32_t denormal_flushes;
+} filtVocoder;
+
+static LV2_Handle instantiateFiltVocoder(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    LV2_Descriptor **descriptors)
+{
+  filtVocoder *plugin_data;
+  double ratio, q, pi2_f;
+  biquadCoefs c;
+  uint32_t bands;
+  uint32_t l1;
+  for (l1 = 0; l1 < VOCODER_DESCRIPTORS; l1++)
+    if (descriptors[l1] == descriptor)
+      break;
+  if (l1 == VOCODER_DESCRIPTORS)
+    return NULL;
+  plugin_data = (filtVocoder *)calloc(1, sizeof(filtVocoder));
+  if (!plugin_data)
+    return NULL;
+  bands = plugin_data->bands = vocoder_bands[l1];
+  plugin_data->rate = s_rate;
+  /* Q for a -3 dB bandwidth of one band spacing, see rbjCoefs() */
+  ratio = pow((double)VOCODER_FREQ_HI / VOCODER_FREQ_LO, 1.0 / (bands - 1));
+  q = sqrt(ratio) / (ratio - 1.0) * 2.0 / Q_SCALE;
+  for (l1 = 0; l1 < bands; l1++) {
+    pi2_f = 2.0 * M_PI / s_rate * VOCODER_FREQ_LO * pow(ratio, l1);
+    rbjCoefs(&c, RBJ_BANDPASS2, sin(pi2_f), cos(pi2_f), q, 1.0, 1.0);
+    plugin_data->b0[l1] = c.b0;
+    plugin_data->a1[l1] = c.a1;
+    plugin_data->a2[l1] = c.a2;
+  }
+  return (LV2_Handle)plugin_data;
+}
+
+static void cleanupFiltVocoder(LV2_Handle instance)
+{
+  free(instance);
+}
+
+static void connectPortFiltVocoder(
+    LV2_Handle instance, uint32_t port, void *data)
+{
+  filtVocoder *plugin = (filtVocoder *)instance;
+  switch(port){
+    case 0: plugin->modulator = data;   break;
+    case 1: plugin->carrier = data;     break;
+    case 2: plugin->output = data;      break;
+    case 3: plugin->gain = data;        break;
+    case 4: plugin->attack = data;      break;
+    case 5: plugin->release = data;     break;
+  }
+}
+
+static void activateFiltVocoder(LV2_Handle instance)
+{
+  filtVocoder *plugin_data = (filtVocoder *)instance;
+  uint32_t bands = plugin_data->bands;
+  plugin_data->mod_x[0] = plugin_data->mod_x[1] = 0;
+  plugin_data->car_x[0] = plugin_data->car_x[1] = 0;
+  memset(plugin_data->mod_u1, 0, bands * sizeof(double));
+  memset(plugin_data->mod_u2, 0, bands * sizeof(double));
+  memset(plugin_data->car_u1, 0, bands * sizeof(double));
+  memset(plugin_data->car_u2, 0, bands * sizeof(double));
+  memset(plugin_data->env, 0, bands * sizeof(double));
+}
+
+/*  Idle when both inputs are silent and every state and envelope has
+    decayed, see runSilent().
+*/
+static inline int silentFiltVocoder(
+    filtVocoder *pluginData, uint32_t sample_count)
+{
+  uint32_t bands = pluginData->bands;
+  if (!blockZero(pluginData->modulator, sample_count)
+      || !blockZero(pluginData->carrier, sample_count)
+      || !stateDecayed(pluginData->mod_x, 2)
+      || !stateDecayed(pluginData->car_x, 2)
+      || !stateDecayed(pluginData->mod_u1, bands)
+      || !stateDecayed(pluginData->mod_u2, bands)
+      || !stateDecayed(pluginData->car_u1, bands)
+      || !stateDecayed(pluginData->car_u2, bands)
+      || !stateDecayed(pluginData->env, bands))
+    return 0;
+  activateFiltVocoder((LV2_Handle)pluginData);
+  memset(pluginData->output, 0, sample_count * sizeof(float));
+  return 1;
+}
+
+/*  VOCODER_LANES bands are held in VOCODER_VECS vectors of two, which
+    every target keeps in registers, see sosRun().
+*/
+typedef double vocoderVec __attribute__((vector_size(2 * sizeof(double))));
+
+static inline void vocoderLoad(vocoderVec *v, const double *p)
+{
+  memcpy(v, p, VOCODER_VECS * sizeof(vocoderVec));
+}
+
+static inline void vocoderStore(double *p, const vocoderVec *v)
+{
+  memcpy(p, v, VOCODER_VECS * sizeof(vocoderVec));
+}
+
+/*  x - x2 for the samples of a tile, the input of every band of a bank.
+    x holds the last two input samples.
+*/
+static inline void diffFiltVocoder(double *x, const float *in, double *d,
+    uint32_t len)
+{
+  uint32_t l1;
+  for (l1 = 0; l1 < len; l1++) {
+    d[l1] = in[l1] - x[1];
+    x[1] = x[0];
+    x[0] = in[l1];
+  }
+}
+
+/*  One tile of the modulator bank, VOCODER_LANES bands at a time with
+    their state in registers; the squared outputs of each band, divided
+    by b0 as the state, are summed into level.  The term on u1 comes
+    last, so only one multiply-add per sample is on the recursion.
+*/
+static inline void modulatorFiltVocoder(filtVocoder *pluginData,
+    const double *d, uint32_t len, double *level)
+{
+  vocoderVec a1[VOCODER_VECS], a2[VOCODER_VECS];
+  vocoderVec u1[VOCODER_VECS], u2[VOCODER_VECS], sum[VOCODER_VECS], u;
+  uint32_t bands = pluginData->bands;
+  uint32_t l1, l2, l3;
+  for (l1 = 0; l1 < bands; l1 += VOCODER_LANES) {
+    vocoderLoad(a1, pluginData->a1 + l1);
+    vocoderLoad(a2, pluginData->a2 + l1);
+    vocoderLoad(u1, pluginData->mod_u1 + l1);
+    vocoderLoad(u2, pluginData->mod_u2 + l1);
+    vocoderLoad(sum, level + l1);
+    for (l2 = 0; l2 < len; l2++) {
+      for (l3 = 0; l3 < VOCODER_VECS; l3++) {
+        u = (d[l2] - a2[l3] * u2[l3]) - a1[l3] * u1[l3];
+        u2[l3] = u1[l3];
+        u1[l3] = u;
+        sum[l3] += u * u;
+      }
+    }
+    vocoderStore(pluginData->mod_u1 + l1, u1);
+    vocoderStore(pluginData->mod_u2 + l1, u2);
+    vocoderStore(level + l1, sum);
+  }
+}
+
+/*  One tile of the carrier bank: the outputs of the bands weighted by
+    gain, which moves by step each sample, and summed into out.  gain
+    and step include the b0 of each band.
+*/
+static inline void carrierFiltVocoder(filtVocoder *pluginData,
+    const double *d, float *out, uint32_t len, const double *gain,
+    const double *step, double out_gain)
+{
+  vocoderVec a1[VOCODER_VECS], a2[VOCODER_VECS];
+  vocoderVec u1[VOCODER_VECS], u2[VOCODER_VECS];
+  vocoderVec g[VOCODER_VECS], g_step[VOCODER_VECS], u, part;
+  vocoderVec acc[VOCODER_TILE];
+  uint32_t bands = pluginData->bands;
+  uint32_t l1, l2, l3;
+  for (l2 = 0; l2 < len; l2++)
+    acc[l2] = (vocoderVec){ 0 };
+  for (l1 = 0; l1 < bands; l1 += VOCODER_LANES) {
+    vocoderLoad(a1, pluginData->a1 + l1);
+    vocoderLoad(a2, pluginData->a2 + l1);
+    vocoderLoad(u1, pluginData->car_u1 + l1);
+    vocoderLoad(u2, pluginData->car_u2 + l1);
+    vocoderLoad(g, gain + l1);
+    vocoderLoad(g_step, step + l1);
+    for (l2 = 0; l2 < len; l2++) {
+      part = acc[l2];
+      for (l3 = 0; l3 < VOCODER_VECS; l3++) {
+        u = (d[l2] - a2[l3] * u2[l3]) - a1[l3] * u1[l3];
+        u2[l3] = u1[l3];
+        u1[l3] = u;
+        g[l3] += g_step[l3];
+        part += g[l3] * u;
+      }
+      acc[l2] = part;
+    }
+    vocoderStore(pluginData->car_u1 + l1, u1);
+    vocoderStore(pluginData->car_u2 + l1, u2);
+  }
+  for (l2 = 0; l2 < len; l2++)
+    out[l2] = out_gain * (acc[l2][0] + acc[l2][1]);
+}
+
+static inline void runFiltVocoder(
+    filtVocoder *pluginData, uint32_t sample_count)
+{
+  uint32_t bands = pluginData->bands;
+  double out_gain = *(pluginData->gain);
+  double attack = *(pluginData->attack) / 1000.0 * pluginData->rate;
+  double release = *(pluginData->release) / 1000.0 * pluginData->rate;
+  double att_tile, rel_tile, att, rel, inv_len, target, c;
+  double level[VOCODER_MAX_BANDS], gain[VOCODER_MAX_BANDS];
+  double step[VOCODER_MAX_BANDS], d[VOCODER_TILE];
+  uint32_t l1, l2, len;
+  fpuMode mode;
+  if (silentFiltVocoder(pluginData, sample_count))
+    return;
+  mode = denormalsOff();
+  attack = (attack > 1) ? attack : 1;
+  release = (release > 1) ? release : 1;
+  att_tile = 1.0 - exp(-VOCODER_TILE / attack);
+  rel_tile = 1.0 - exp(-VOCODER_TILE / release);
+  for (l1 = 0; l1 < sample_count; l1 += len) {
+    len = sample_count - l1;
+    if (len > VOCODER_TILE)
+      len = VOCODER_TILE;
+    att = (len == VOCODER_TILE)
+        ? att_tile : 1.0 - exp(-(double)len / attack);
+    rel = (len == VOCODER_TILE)
+        ? rel_tile : 1.0 - exp(-(double)len / release);
+    inv_len = 1.0 / len;
+    memset(level, 0, bands * sizeof(double));
+    diffFiltVocoder(pluginData->mod_x, pluginData->modulator + l1, d, len);
+    modulatorFiltVocoder(pluginData, d, len, level);
+    for (l2 = 0; l2 < bands; l2++) {
+      target = pluginData->b0[l2] * sqrt(level[l2] * inv_len);
+      c = (target > pluginData->env[l2]) ? att : rel;
+      gain[l2] = pluginData->b0[l2] * pluginData->env[l2];
+      pluginData->env[l2] += c * (target - pluginData->env[l2]);
+      step[l2] = (pluginData->b0[l2] * pluginData->env[l2] - gain[l2])
+          * inv_len;
+    }
+    diffFiltVocoder(pluginData->car_x, pluginData->carrier + l1, d, len);
+    carrierFiltVocoder(pluginData, d, pluginData->output + l1, len, gain,
+                       step, out_gain);
+  }
+  pluginData->denormal_flushes +=
+      flushDenormals(pluginData->mod_u1, bands)
+      | flushDenormals(pluginData->mod_u2, bands)
+      | flushDenormals(pluginData->car_u1, bands)
+      | flushDenormals(pluginData->car_u2, bands)
+      | flushDenormals(pluginData->env, bands);
+  denormalsRestore(mode);
+}
+
+#endif
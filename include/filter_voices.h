@@ -0,0 +1,414 @@
+#ifndef FILTER_VOICES_H
+#define FILTER_VOICES_H
+
+/*  Voice banks: one instance filtering several independent voices, each
+    with its own audio and CV inputs, for polyphonic synths that would
+    otherwise run one _cv instance per voice.
+
+    Port layout: the voice inputs, the voice outputs, the freq_in CVs,
+    the reso_in CVs and, where the filter has one, the dBgain_in CVs,
+    each group in voice order.  Then the controls shared by all voices:
+    gain, freq_ofs, freq_pitch, reso_ofs, dBgain_ofs where the filter has
+    one, and mod_rate.  Unconnected CV inputs read as 0.
+
+    The voice states are kept together as structure-of-arrays lanes.
+    Audio and CVs move through in tiles of VOICES_TILE samples, and the
+    coefficients of a whole tile are computed before the recursion runs
+    over it, each step working across all voices at once.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <lv2.h>
+
+#include "biquad.h"
+
+#define VOICES_DESCRIPTORS     3
+#define VOICES_MAX            32
+#define VOICES_TILE           16
+
+static const uint32_t voices_counts[VOICES_DESCRIPTORS] = { 8, 16, 32 };
+
+typedef struct {
+  float *input[VOICES_MAX];
+  float *output[VOICES_MAX];
+  float *freq_in[VOICES_MAX];
+  float *reso_in[VOICES_MAX];
+  float *dBgain_in[VOICES_MAX];
+  float *gain;
+  float *freq_ofs;
+  float *freq_pitch;
+  float *reso_ofs;
+  float *dBgain_ofs;
+  float *mod_rate;
+  uint32_t voices;
+  int has_dBgain;
+  double rate;
+} filtVoicePorts;
+
+typedef struct {
+  double b0[VOICES_MAX];
+  double b1[VOICES_MAX];
+  double b2[VOICES_MAX];
+  double a1[VOICES_MAX];
+  double a2[VOICES_MAX];
+} voiceCoefs;
+
+/*  Voice bank of an RBJ filter.  coefs, target and step carry the ramp
+    between two decimated updates; the tile arrays hold the coefficients,
+    CVs and audio of each sample of the current tile, one row per sample.
+*/
+typedef struct {
+  filtVoicePorts ports;
+  coefTable *table;
+  voiceCoefs coefs, target, step;
+  int coefs_valid;
+  double x1[VOICES_MAX], x2[VOICES_MAX], y1[VOICES_MAX], y2[VOICES_MAX];
+  double b0[VOICES_TILE][VOICES_MAX], b1[VOICES_TILE][VOICES_MAX];
+  double b2[VOICES_TILE][VOICES_MAX], a1[VOICES_TILE][VOICES_MAX];
+  double a2[VOICES_TILE][VOICES_MAX];
+  double freq[VOICES_TILE][VOICES_MAX], reso[VOICES_TILE][VOICES_MAX];
+  double dBgain[VOICES_TILE][VOICES_MAX];
+  double in[VOICES_TILE][VOICES_MAX], out[VOICES_TILE][VOICES_MAX];
+  uint32_t denormal_flushes;
+} filtVoices;
+
+/* Number of voices of descriptor, or 0 if it is not one of descriptors */
+static inline uint32_t voicesOfDescriptor(
+    const LV2_Descriptor *descriptor, LV2_Descriptor **descriptors)
+{
+  int l1;
+  for (l1 = 0; l1 < VOICES_DESCRIPTORS; l1++)
+    if (descriptors[l1] == descriptor)
+      return voices_counts[l1];
+  return 0;
+}
+
+static inline void connectPortVoices(
+    filtVoicePorts *ports, uint32_t port, void *data)
+{
+  float **groups[5] = {
+    ports->input, ports->output, ports->freq_in, ports->reso_in,
+    ports->dBgain_in
+  };
+  uint32_t count = (ports->has_dBgain) ? 5 : 4;
+  if (port < count * ports->voices) {
+    groups[port / ports->voices][port % ports->voices] = data;
+    return;
+  }
+  port -= count * ports->voices;
+  if (!ports->has_dBgain && port >= 4)
+    port++;
+  switch(port){
+    case 0: ports->gain = data;        break;
+    case 1: ports->freq_ofs = data;    break;
+    case 2: ports->freq_pitch = data;  break;
+    case 3: ports->reso_ofs = data;    break;
+    case 4: ports->dBgain_ofs = data;  break;
+    case 5: ports->mod_rate = data;    break;
+  }
+}
+
+static inline uint32_t modStepVoices(const filtVoicePorts *ports)
+{
+  uint32_t mod_step = (*(ports->mod_rate) > 1)
+      ? (uint32_t)*(ports->mod_rate) : 1;
+  return (mod_step > MOD_RATE_MAX) ? MOD_RATE_MAX : mod_step;
+}
+
+/* Sample i of one CV input of every voice */
+static inline void loadCVVoices(
+    double *cv, float * const *in, uint32_t voices, uint32_t i)
+{
+  uint32_t l1;
+  for (l1 = 0; l1 < voices; l1++)
+    cv[l1] = (in[l1]) ? in[l1][i] : 0;
+}
+
+/* Samples [first, first + len) of every voice into the rows of tile */
+static inline void loadTileVoices(double (*tile)[VOICES_MAX],
+    float * const *in, uint32_t voices, uint32_t first, uint32_t len)
+{
+  uint32_t l1, l2;
+  for (l1 = 0; l1 < voices; l1++) {
+    if (in[l1]) {
+      const float *src = in[l1] + first;
+      for (l2 = 0; l2 < len; l2++)
+        tile[l2][l1] = src[l2];
+    }
+    else {
+      for (l2 = 0; l2 < len; l2++)
+        tile[l2][l1] = 0;
+    }
+  }
+}
+
+static inline void storeTileVoices(float * const *out,
+    double (*tile)[VOICES_MAX], uint32_t voices, uint32_t first,
+    uint32_t len)
+{
+  uint32_t l1, l2;
+  for (l1 = 0; l1 < voices; l1++) {
+    float *dst = out[l1] + first;
+    for (l2 = 0; l2 < len; l2++)
+      dst[l2] = tile[l2][l1];
+  }
+}
+
+/* Nonzero if the input of every voice holds 0 for count samples */
+static inline int inputsZeroVoices(
+    float * const *in, uint32_t voices, uint32_t count)
+{
+  uint32_t l1;
+  for (l1 = 0; l1 < voices; l1++)
+    if (in[l1] && !blockZero(in[l1], count))
+      return 0;
+  return 1;
+}
+
+static inline void zeroOutputsVoices(
+    float * const *out, uint32_t voices, uint32_t count)
+{
+  uint32_t l1;
+  for (l1 = 0; l1 < voices; l1++)
+    memset(out[l1], 0, count * sizeof(float));
+}
+
+static inline LV2_Handle instantiateFiltVoices(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    LV2_Descriptor **descriptors,
+    int has_dBgain)
+{
+  filtVoices *plugin_data;
+  uint32_t voices = voicesOfDescriptor(descriptor, descriptors);
+  if (!voices)
+    return NULL;
+  plugin_data = (filtVoices *)calloc(1, sizeof(filtVoices));
+  if (!plugin_data)
+    return NULL;
+  plugin_data->table = coefTableAcquire(s_rate);
+  if (!plugin_data->table) {
+    free(plugin_data);
+    return NULL;
+  }
+  plugin_data->ports.voices = voices;
+  plugin_data->ports.has_dBgain = has_dBgain;
+  plugin_data->ports.rate = s_rate;
+  return (LV2_Handle)plugin_data;
+}
+
+static inline void cleanupFiltVoices(LV2_Handle instance)
+{
+  filtVoices *plugin_data = (filtVoices *)instance;
+  coefTableRelease(plugin_data->table);
+  free(instance);
+}
+
+static inline void connectPortFiltVoices(
+    LV2_Handle instance, uint32_t port, void *data)
+{
+  connectPortVoices(&((filtVoices *)instance)->ports, port, data);
+}
+
+static inline void activateFiltVoices(LV2_Handle instance)
+{
+  filtVoices *plugin_data = (filtVoices *)instance;
+  int l1;
+  for (l1 = 0; l1 < VOICES_MAX; l1++) {
+    plugin_data->x1[l1] = plugin_data->x2[l1] = 0;
+    plugin_data->y1[l1] = plugin_data->y2[l1] = 0;
+  }
+  plugin_data->coefs_valid = 0;
+}
+
+/*  Coefficients of every voice from one sample of the CVs, as
+    rbjCVCoefs() computes them for a _cv instance.
+*/
+static inline void coefsFiltVoices(filtVoices *pluginData, int type,
+    double *b0, double *b1, double *b2, double *a1, double *a2,
+    const double *freq, const double *reso, const double *dBgain,
+    double f0, double freq_pitch, double q0, double dBgain0, double gain)
+{
+  uint32_t voices = pluginData->ports.voices;
+  uint32_t l1;
+  double f[VOICES_MAX], q[VOICES_MAX], A[VOICES_MAX];
+  double iv_sin[VOICES_MAX], iv_cos[VOICES_MAX];
+  for (l1 = 0; l1 < voices; l1++) {
+    f[l1] = (freq[l1] > 0)
+        ? (freq[l1] * MAX_FREQ + f0 - MIN_FREQ) * freq_pitch
+        : f0 * freq_pitch;
+    f[l1] = (f[l1] < MIN_FREQ) ? MIN_FREQ : f[l1];
+    f[l1] = (f[l1] > MAX_FREQ) ? MAX_FREQ : f[l1];
+    q[l1] = q0 + reso[l1];
+    q[l1] = (q[l1] < Q_MIN) ? Q_MIN : q[l1];
+    q[l1] = (q[l1] > Q_MAX) ? Q_MAX : q[l1];
+  }
+  if (type >= RBJ_PEAK_EQ) {
+    for (l1 = 0; l1 < voices; l1++)
+      A[l1] = coefTableDbToA(dBgain0 + DBGAIN_SCALE * dBgain[l1]);
+  }
+  else {
+    for (l1 = 0; l1 < voices; l1++)
+      A[l1] = 1.0;
+  }
+  for (l1 = 0; l1 < voices; l1++)
+    coefTableSinCos(pluginData->table, f[l1], &iv_sin[l1], &iv_cos[l1]);
+  rbjLaneCoefs(b0, b1, b2, a1, a2, type, iv_sin, iv_cos, q, A, gain,
+               voices);
+}
+
+/* Decimated target coefficients of every voice for sample i */
+static inline void targetFiltVoices(filtVoices *pluginData, int type,
+    double f0, double freq_pitch, double q0, double dBgain0, double gain,
+    uint32_t i)
+{
+  filtVoicePorts *ports = &pluginData->ports;
+  voiceCoefs *target = &pluginData->target;
+  double freq[VOICES_MAX], reso[VOICES_MAX], dBgain[VOICES_MAX];
+  loadCVVoices(freq, ports->freq_in, ports->voices, i);
+  loadCVVoices(reso, ports->reso_in, ports->voices, i);
+  loadCVVoices(dBgain, ports->dBgain_in, ports->voices, i);
+  coefsFiltVoices(pluginData, type, target->b0, target->b1, target->b2,
+                  target->a1, target->a2, freq, reso, dBgain,
+                  f0, freq_pitch, q0, dBgain0, gain);
+}
+
+/* Run the recursion over the first len rows of the tile */
+static inline void runTileFiltVoices(filtVoices *pluginData, uint32_t len)
+{
+  uint32_t voices = pluginData->ports.voices;
+  uint32_t l1, l2;
+  for (l1 = 0; l1 < len; l1++) {
+    for (l2 = 0; l2 < voices; l2++) {
+      pluginData->out[l1][l2] = pluginData->b0[l1][l2] * pluginData->in[l1][l2]
+          + pluginData->b1[l1][l2] * pluginData->x1[l2]
+          + pluginData->b2[l1][l2] * pluginData->x2[l2]
+          - pluginData->a1[l1][l2] * pluginData->y1[l2]
+          - pluginData->a2[l1][l2] * pluginData->y2[l2];
+      pluginData->x2[l2] = pluginData->x1[l2];
+      pluginData->x1[l2] = pluginData->in[l1][l2];
+      pluginData->y2[l2] = pluginData->y1[l2];
+      pluginData->y1[l2] = pluginData->out[l1][l2];
+    }
+  }
+}
+
+/*  The whole bank is idle when every input is silent and every state has
+    decayed, see runSilent(); the ramp restarts from the CVs when the
+    input resumes.
+*/
+static inline int silentFiltVoices(
+    filtVoices *pluginData, uint32_t sample_count)
+{
+  uint32_t voices = pluginData->ports.voices;
+  if (!inputsZeroVoices(pluginData->ports.input, voices, sample_count)
+      || !stateDecayed(pluginData->x1, voices)
+      || !stateDecayed(pluginData->x2, voices)
+      || !stateDecayed(pluginData->y1, voices)
+      || !stateDecayed(pluginData->y2, voices))
+    return 0;
+  memset(pluginData->x1, 0, voices * sizeof(double));
+  memset(pluginData->x2, 0, voices * sizeof(double));
+  memset(pluginData->y1, 0, voices * sizeof(double));
+  memset(pluginData->y2, 0, voices * sizeof(double));
+  zeroOutputsVoices(pluginData->ports.output, voices, sample_count);
+  pluginData->coefs_valid = 0;
+  return 1;
+}
+
+/*  With mod_rate 1 the coefficients follow the CVs sample by sample;
+    otherwise they are recomputed every mod_rate samples and ramped in
+    between, as in the decimated _cv path.  Meant to be inlined with a
+    constant type into a VCF_SIMD run function.
+*/
+static inline void runFiltVoices(
+    filtVoices *pluginData, uint32_t sample_count, int type)
+{
+  filtVoicePorts *ports = &pluginData->ports;
+  voiceCoefs *coefs = &pluginData->coefs;
+  voiceCoefs *target = &pluginData->target;
+  voiceCoefs *step = &pluginData->step;
+  uint32_t voices = ports->voices;
+  uint32_t mod_step = modStepVoices(ports);
+  uint32_t l1, l2, l3, len, seg_end = 0;
+  double inv_len;
+  double gain = *(ports->gain);
+  double f0 = *(ports->freq_ofs);
+  double freq_pitch =
+      (*(ports->freq_pitch) > 0)
+          ? 1.0 + *(ports->freq_pitch) / 2.0
+          : 1.0 / (1.0 - *(ports->freq_pitch) / 2.0);
+  double q0 = *(ports->reso_ofs);
+  double dBgain0 = (ports->dBgain_ofs) ? *(ports->dBgain_ofs) : 0;
+  fpuMode mode;
+  if (silentFiltVoices(pluginData, sample_count))
+    return;
+  mode = denormalsOff();
+  if (mod_step == 1)
+    pluginData->coefs_valid = 0;
+  for (l1 = 0; l1 < sample_count; l1 += len) {
+    len = sample_count - l1;
+    if (len > VOICES_TILE)
+      len = VOICES_TILE;
+    loadTileVoices(pluginData->in, ports->input, voices, l1, len);
+    if (mod_step == 1) {
+      loadTileVoices(pluginData->freq, ports->freq_in, voices, l1, len);
+      loadTileVoices(pluginData->reso, ports->reso_in, voices, l1, len);
+      if (type >= RBJ_PEAK_EQ)
+        loadTileVoices(pluginData->dBgain, ports->dBgain_in, voices,
+                       l1, len);
+      for (l2 = 0; l2 < len; l2++)
+        coefsFiltVoices(pluginData, type,
+                        pluginData->b0[l2], pluginData->b1[l2],
+                        pluginData->b2[l2], pluginData->a1[l2],
+                        pluginData->a2[l2], pluginData->freq[l2],
+                        pluginData->reso[l2], pluginData->dBgain[l2],
+                        f0, freq_pitch, q0, dBgain0, gain);
+    }
+    else {
+      for (l2 = 0; l2 < len; l2++) {
+        if (l1 + l2 == seg_end) {
+          seg_end = l1 + l2 + mod_step;
+          if (seg_end > sample_count)
+            seg_end = sample_count;
+          if (!pluginData->coefs_valid) {
+            targetFiltVoices(pluginData, type, f0, freq_pitch, q0,
+                             dBgain0, gain, l1 + l2);
+            *coefs = *target;
+            pluginData->coefs_valid = 1;
+          }
+          targetFiltVoices(pluginData, type, f0, freq_pitch, q0,
+                           dBgain0, gain, seg_end - 1);
+          inv_len = 1.0 / (seg_end - l1 - l2);
+          for (l3 = 0; l3 < voices; l3++) {
+            step->b0[l3] = (target->b0[l3] - coefs->b0[l3]) * inv_len;
+            step->b1[l3] = (target->b1[l3] - coefs->b1[l3]) * inv_len;
+            step->b2[l3] = (target->b2[l3] - coefs->b2[l3]) * inv_len;
+            step->a1[l3] = (target->a1[l3] - coefs->a1[l3]) * inv_len;
+            step->a2[l3] = (target->a2[l3] - coefs->a2[l3]) * inv_len;
+          }
+        }
+        for (l3 = 0; l3 < voices; l3++) {
+          pluginData->b0[l2][l3] = coefs->b0[l3] += step->b0[l3];
+          pluginData->b1[l2][l3] = coefs->b1[l3] += step->b1[l3];
+          pluginData->b2[l2][l3] = coefs->b2[l3] += step->b2[l3];
+          pluginData->a1[l2][l3] = coefs->a1[l3] += step->a1[l3];
+          pluginData->a2[l2][l3] = coefs->a2[l3] += step->a2[l3];
+        }
+        if (l1 + l2 + 1 == seg_end)
+          *coefs = *target;
+      }
+    }
+    runTileFiltVoices(pluginData, len);
+    storeTileVoices(ports->output, pluginData->out, voices, l1, len);
+  }
+  pluginData->denormal_flushes +=
+      flushDenormals(pluginData->x1, voices)
+      | flushDenormals(pluginData->x2, voices)
+      | flushDenormals(pluginData->y1, voices)
+      | flushDenormals(pluginData->y2, voices);
+  denormalsRestore(mode);
+}
+
+#endif
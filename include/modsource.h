@@ -0,0 +1,338 @@
+#ifndef MODSOURCE_H
+#define MODSOURCE_H
+
+/*  Internal modulation sources of the _cv plugins: an LFO, free
+    running at lfo_rate or, with lfo_sync on and a host that sends
+    time:Position, one cycle every lfo_beats beats of the transport; or
+    an envelope follower on the input, for auto-wah.
+
+    Port layout, after the ports of the _cv plugin: mod_source, lfo_shape,
+    lfo_rate, lfo_sync, lfo_beats, mod_freq_depth in octaves,
+    mod_reso_depth, env_attack, env_release, env_sens, and the control
+    atom input the transport arrives on.
+
+    The source is evaluated at control rate, once every MOD_STEP samples,
+    and moves freq_ofs by mod_freq_depth octaves and reso_ofs by
+    mod_reso_depth at full swing.  Between two steps the coefficients
+    are ramped, so a modulated plugin computes its coefficients once per
+    step instead of per sample, and needs no audio rate CV from another
+    plugin.  The CV inputs still add to the moved offsets.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <lv2.h>
+#include <lv2/lv2plug.in/ns/ext/atom/util.h>
+#include <lv2/lv2plug.in/ns/ext/urid/urid.h>
+#include <lv2/lv2plug.in/ns/ext/time/time.h>
+
+#include "biquad.h"
+#include "sos.h"
+
+#define MOD_STEP              16
+#define MOD_PORTS             11
+
+enum {
+  MOD_OFF,
+  MOD_LFO,
+  MOD_ENVELOPE
+};
+
+enum {
+  LFO_SINE,
+  LFO_TRIANGLE,
+  LFO_SAW,
+  LFO_SQUARE,
+  LFO_RANDOM
+};
+
+typedef struct {
+  LV2_URID atom_Blank;
+  LV2_URID atom_Object;
+  LV2_URID atom_Float;
+  LV2_URID atom_Double;
+  LV2_URID time_Position;
+  LV2_URID time_beat;
+  LV2_URID time_beatsPerMinute;
+  LV2_URID time_speed;
+} modURIDs;
+
+typedef struct {
+  float *source;
+  float *shape;
+  float *lfo_rate;
+  float *sync;
+  float *beats;
+  float *freq_depth;
+  float *reso_depth;
+  float *attack;
+  float *release;
+  float *sens;
+  const LV2_Atom_Sequence *control;
+  modURIDs uris;
+  int has_map;
+  double rate;
+  double phase, held, env, att, rel;
+  double bpm, speed;
+  int has_position;
+  uint32_t seed;
+} modSource;
+
+static inline void modSourceInit(modSource *mod, double s_rate,
+    const LV2_Feature * const* features)
+{
+  LV2_URID_Map *map = NULL;
+  int l1;
+  memset(mod, 0, sizeof(modSource));
+  mod->rate = s_rate;
+  mod->seed = 1;
+  mod->speed = 1.0;
+  for (l1 = 0; features && features[l1]; l1++)
+    if (!strcmp(features[l1]->URI, LV2_URID__map))
+      map = (LV2_URID_Map *)features[l1]->data;
+  if (!map)
+    return;
+  mod->uris.atom_Blank = map->map(map->handle, LV2_ATOM__Blank);
+  mod->uris.atom_Object = map->map(map->handle, LV2_ATOM__Object);
+  mod->uris.atom_Float = map->map(map->handle, LV2_ATOM__Float);
+  mod->uris.atom_Double = map->map(map->handle, LV2_ATOM__Double);
+  mod->uris.time_Position = map->map(map->handle, LV2_TIME__Position);
+  mod->uris.time_beat = map->map(map->handle, LV2_TIME__beat);
+  mod->uris.time_beatsPerMinute =
+      map->map(map->handle, LV2_TIME__beatsPerMinute);
+  mod->uris.time_speed = map->map(map->handle, LV2_TIME__speed);
+  mod->has_map = 1;
+}
+
+/* port counts from the first port after those of the _cv plugin */
+static inline void modSourceConnect(modSource *mod, uint32_t port,
+    void *data)
+{
+  switch(port){
+    case 0:  mod->source = data;        break;
+    case 1:  mod->shape = data;         break;
+    case 2:  mod->lfo_rate = data;      break;
+    case 3:  mod->sync = data;          break;
+    case 4:  mod->beats = data;         break;
+    case 5:  mod->freq_depth = data;    break;
+    case 6:  mod->reso_depth = data;    break;
+    case 7:  mod->attack = data;        break;
+    case 8:  mod->release = data;       break;
+    case 9:  mod->sens = data;          break;
+    case 10: mod->control = data;       break;
+  }
+}
+
+static inline int modSourceType(const modSource *mod)
+{
+  if (!mod->source || *(mod->source) < 0.5f)
+    return MOD_OFF;
+  return (*(mod->source) < 1.5f) ? MOD_LFO : MOD_ENVELOPE;
+}
+
+/*  Number of a time:Position property, which hosts send as float or
+    double; nonzero if it was one.
+*/
+static inline int modAtomNumber(const modSource *mod, const LV2_Atom *atom,
+    double *value)
+{
+  if (!atom)
+    return 0;
+  if (atom->type == mod->uris.atom_Float)
+    *value = ((const LV2_Atom_Float *)atom)->body;
+  else if (atom->type == mod->uris.atom_Double)
+    *value = ((const LV2_Atom_Double *)atom)->body;
+  else
+    return 0;
+  return 1;
+}
+
+/*  Take the tempo and position of the transport from the time:Position
+    objects of the block; the LFO phase is set from the position of the
+    last one, moved back to the start of the block.
+*/
+static inline void modSourceEvents(modSource *mod)
+{
+  const LV2_Atom *beat, *bpm, *speed;
+  const LV2_Atom_Object *obj;
+  double value, position = 0;
+  int64_t frames = 0;
+  int has_beat = 0;
+  if (!mod->control || !mod->has_map)
+    return;
+  LV2_ATOM_SEQUENCE_FOREACH(mod->control, ev) {
+    if (ev->body.type != mod->uris.atom_Object
+        && ev->body.type != mod->uris.atom_Blank)
+      continue;
+    obj = (const LV2_Atom_Object *)&ev->body;
+    if (obj->body.otype != mod->uris.time_Position)
+      continue;
+    beat = bpm = speed = NULL;
+    lv2_atom_object_get(obj, mod->uris.time_beat, &beat,
+                        mod->uris.time_beatsPerMinute, &bpm,
+                        mod->uris.time_speed, &speed, 0);
+    if (modAtomNumber(mod, bpm, &value) && value > 0)
+      mod->bpm = value;
+    if (modAtomNumber(mod, speed, &value))
+      mod->speed = value;
+    if (modAtomNumber(mod, beat, &value)) {
+      position = value;
+      frames = ev->time.frames;
+      has_beat = 1;
+    }
+    mod->has_position = (mod->bpm > 0);
+  }
+  if (has_beat && mod->has_position && mod->sync && *(mod->sync) > 0
+      && mod->beats && *(mod->beats) > 0) {
+    position -= frames * mod->bpm * mod->speed / (60.0 * mod->rate);
+    value = position / *(mod->beats);
+    mod->phase = value - floor(value);
+  }
+}
+
+/*  Read the transport and the one-pole coefficients for the block;
+    nonzero if a source is selected.
+*/
+static inline int modSourceBegin(modSource *mod)
+{
+  int type = modSourceType(mod);
+  if (type == MOD_OFF)
+    return 0;
+  modSourceEvents(mod);
+  if (type == MOD_ENVELOPE) {
+    mod->att = 1.0 - exp(-MOD_STEP / (*(mod->attack) * 0.001 * mod->rate));
+    mod->rel = 1.0 - exp(-MOD_STEP / (*(mod->release) * 0.001 * mod->rate));
+  }
+  return 1;
+}
+
+/* LFO frequency in cycles per sample */
+static inline double modLFOFreq(const modSource *mod)
+{
+  if (mod->sync && *(mod->sync) > 0 && mod->has_position && mod->beats
+      && *(mod->beats) > 0)
+    return mod->bpm * mod->speed / (60.0 * *(mod->beats) * mod->rate);
+  return *(mod->lfo_rate) / mod->rate;
+}
+
+/* Move the LFO phase on by len samples, drawing a new random value on wrap */
+static inline void modLFOAdvance(modSource *mod, uint32_t len)
+{
+  mod->phase += len * modLFOFreq(mod);
+  if (mod->phase >= 1.0 || mod->phase < 0) {
+    mod->phase -= floor(mod->phase);
+    mod->seed = mod->seed * 1664525u + 1013904223u;
+    mod->held = (mod->seed >> 8) * (2.0 / 16777216.0) - 1.0;
+  }
+}
+
+/*  Value of the source at the end of the next len samples of input, from
+    -1 to 1 for the LFO and 0 to 1 for the envelope.
+*/
+static inline double modSourceStep(modSource *mod, const float *input,
+    uint32_t len)
+{
+  double p, level = 0;
+  uint32_t l1;
+  if (modSourceType(mod) == MOD_ENVELOPE) {
+    for (l1 = 0; l1 < len; l1++)
+      level += input[l1] * input[l1];
+    level = sqrt(level / len);
+    mod->env += ((level > mod->env) ? mod->att : mod->rel)
+        * (double)len / MOD_STEP * (level - mod->env);
+    level = *(mod->sens) * mod->env;
+    return (level < 1.0) ? level : 1.0;
+  }
+  modLFOAdvance(mod, len);
+  p = mod->phase;
+  switch ((int)(*(mod->shape) + 0.5f)) {
+  case LFO_SINE:
+    return sin(2.0 * M_PI * p);
+  case LFO_TRIANGLE:
+    return 1.0 - 4.0 * fabs(p - 0.5);
+  case LFO_SAW:
+    return 2.0 * p - 1.0;
+  case LFO_SQUARE:
+    return (p < 0.5) ? 1.0 : -1.0;
+  default:
+    return mod->held;
+  }
+}
+
+/*  Let len samples of an idle block pass: the LFO keeps its phase and the
+    envelope falls away.
+*/
+static inline void modSourceIdle(modSource *mod, uint32_t len)
+{
+  if (modSourceType(mod) == MOD_ENVELOPE)
+    mod->env *= pow(1.0 - mod->rel, (double)len / MOD_STEP);
+  else
+    modLFOAdvance(mod, len);
+}
+
+/*  run() of a _cv instance with a source selected, see modSourceBegin():
+    the CV offsets of cv are moved by the source every MOD_STEP samples
+    and the block is run a step at a time, through rbjCVRun() or, for a
+    cascade, sosCVRun(); sos is NULL for a plain biquad.  With no CV
+    connected the coefficients ramp from step to step, see
+    biquadRunRamp() and sosRunRamp().  *coefs_valid covers coefs or,
+    with a cascade, the sections of sos.
+    type and conn are expected to be constants.
+*/
+static inline void modCVRun(modSource *mod, rbjCV *cv, int type, int conn,
+    sosCascade *sos, biquadCoefs *coefs, int *coefs_valid, double *buf,
+    const float *input, float *output, uint32_t sample_count,
+    uint32_t mod_step)
+{
+  const float *freq_in = cv->freq_in, *reso_in = cv->reso_in;
+  const float *dBgain_in = cv->dBgain_in;
+  double f0 = cv->f0, q0 = cv->q0, value;
+  biquadCoefs c;
+  sosCascade target;
+  uint32_t l1, len;
+  if (runSilent(input, output, buf, sos ? 4 * sos->sections : 4,
+                sample_count)) {
+    modSourceIdle(mod, sample_count);
+    *coefs_valid = 0;
+    return;
+  }
+  for (l1 = 0; l1 < sample_count; l1 += len) {
+    len = sample_count - l1;
+    if (len > MOD_STEP)
+      len = MOD_STEP;
+    value = modSourceStep(mod, input + l1, len);
+    cv->f0 = f0 * exp2(*(mod->freq_depth) * value);
+    cv->q0 = q0 + *(mod->reso_depth) * value;
+    cv->freq_in = (conn & CV_FREQ) ? freq_in + l1 : NULL;
+    cv->reso_in = (conn & CV_RESO) ? reso_in + l1 : NULL;
+    cv->dBgain_in = (conn & CV_DBGAIN) ? dBgain_in + l1 : NULL;
+    if (sos && conn) {
+      sosCVRun(cv, type, conn, sos, coefs_valid, buf, input + l1,
+               output + l1, len, mod_step);
+    }
+    else if (sos) {
+      target = *sos;
+      sosCVDesign(&target, type, conn, cv, 0);
+      if (!*coefs_valid)
+        *sos = target;
+      *coefs_valid = 1;
+      sosRunRamp(sos, &target, buf, input + l1, output + l1, len);
+    }
+    else if (conn) {
+      rbjCVRun(cv, type, conn, coefs, coefs_valid, buf, input + l1,
+               output + l1, len, mod_step);
+    }
+    else {
+      rbjCVCoefs(&c, type, conn, cv, 0);
+      if (!*coefs_valid)
+        *coefs = c;
+      *coefs_valid = 1;
+      biquadRunRamp(coefs, &c, buf, input + l1, output + l1, len);
+    }
+  }
+  cv->f0 = f0;
+  cv->q0 = q0;
+}
+
+#endif
@@ -0,0 +1,169 @@
+#ifndef PARAMEVENTS_H
+#define PARAMEVENTS_H
+
+/*  Sample accurate parameter changes for the static plugins: patch:Set
+    events on a control atom input set the frequency, the resonance and
+    the dB gain of the filter, in place of the freq_ofs, reso_ofs and
+    dBgain_ofs ports, at the frame of the event.
+
+    The run function splits the block at the events and runs each span
+    with the parameters as they stand, so the coefficients are only
+    recomputed at the events, see paramNext().  A value set by an event
+    holds until the next event or until the host moves the control port
+    it stands in for, whichever comes first.
+
+    The events are taken by the static RBJ plugins and resonant_lowpass,
+    whose freq_ofs and reso_ofs ports they stand in for.  The _cv, _svf
+    and _voices descriptors already follow freq_in and reso_in a sample at
+    a time, so an event path would only compete with the CV for the same
+    parameter.  _dyn moves dBgain itself from its detector.  The _multi
+    banks share one set of coefficients across all channels and the
+    mid/side paths; they keep the control ports, which hold for the whole
+    block.  The crossover, graphic EQ and vocoder have no single freq and
+    reso to set.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <lv2.h>
+#include <lv2/lv2plug.in/ns/ext/atom/util.h>
+#include <lv2/lv2plug.in/ns/ext/urid/urid.h>
+#include <lv2/lv2plug.in/ns/ext/patch/patch.h>
+
+#define VCF_PARAM_URI         "http://jwm-art.net/lv2/vcf/param#"
+
+enum {
+  PARAM_FREQ,
+  PARAM_RESO,
+  PARAM_DBGAIN,
+  PARAM_COUNT
+};
+
+static const char *param_uri[PARAM_COUNT] = {
+  VCF_PARAM_URI "freq",
+  VCF_PARAM_URI "reso",
+  VCF_PARAM_URI "dBgain"
+};
+
+typedef struct {
+  const LV2_Atom_Sequence *control;
+  const LV2_Atom_Event *next;
+  LV2_URID atom_Blank;
+  LV2_URID atom_Object;
+  LV2_URID atom_Float;
+  LV2_URID atom_Double;
+  LV2_URID atom_URID;
+  LV2_URID patch_Set;
+  LV2_URID patch_property;
+  LV2_URID patch_value;
+  LV2_URID param[PARAM_COUNT];
+  int has_map;
+  int set[PARAM_COUNT];
+  float value[PARAM_COUNT];
+  float port[PARAM_COUNT];
+} paramEvents;
+
+static inline void paramEventsInit(paramEvents *pe,
+    const LV2_Feature * const* features)
+{
+  LV2_URID_Map *map = NULL;
+  int l1;
+  memset(pe, 0, sizeof(paramEvents));
+  for (l1 = 0; features && features[l1]; l1++)
+    if (!strcmp(features[l1]->URI, LV2_URID__map))
+      map = (LV2_URID_Map *)features[l1]->data;
+  if (!map)
+    return;
+  pe->atom_Blank = map->map(map->handle, LV2_ATOM__Blank);
+  pe->atom_Object = map->map(map->handle, LV2_ATOM__Object);
+  pe->atom_Float = map->map(map->handle, LV2_ATOM__Float);
+  pe->atom_Double = map->map(map->handle, LV2_ATOM__Double);
+  pe->atom_URID = map->map(map->handle, LV2_ATOM__URID);
+  pe->patch_Set = map->map(map->handle, LV2_PATCH__Set);
+  pe->patch_property = map->map(map->handle, LV2_PATCH__property);
+  pe->patch_value = map->map(map->handle, LV2_PATCH__value);
+  for (l1 = 0; l1 < PARAM_COUNT; l1++)
+    pe->param[l1] = map->map(map->handle, param_uri[l1]);
+  pe->has_map = 1;
+}
+
+/*  Start of a block: the parameters from the control ports, NULL for a
+    parameter the plugin does not have, or from the last event setting
+    them if the port has not moved since; and the first event.
+*/
+static inline void paramBegin(paramEvents *pe, float *const *ports,
+    float *values)
+{
+  int l1;
+  for (l1 = 0; l1 < PARAM_COUNT; l1++) {
+    values[l1] = ports[l1] ? *(ports[l1]) : 0;
+    if (!pe->set[l1])
+      continue;
+    if (values[l1] == pe->port[l1])
+      values[l1] = pe->value[l1];
+    else
+      pe->set[l1] = 0;
+  }
+  pe->next = (pe->control && pe->has_map)
+      ? lv2_atom_sequence_begin(&pe->control->body) : NULL;
+}
+
+/*  Frame of the next parameter event of the block, at most sample_count,
+    with its parameter and value; sample_count with *index -1 when there
+    are none left.
+*/
+static inline uint32_t paramNext(paramEvents *pe, uint32_t sample_count,
+    int *index, float *value)
+{
+  const LV2_Atom_Event *ev;
+  const LV2_Atom_Object *obj;
+  const LV2_Atom *property, *atom;
+  int l1;
+  *index = -1;
+  while (pe->next
+         && !lv2_atom_sequence_is_end(&pe->control->body,
+                                      pe->control->atom.size, pe->next)) {
+    ev = pe->next;
+    pe->next = lv2_atom_sequence_next(ev);
+    if (ev->body.type != pe->atom_Object && ev->body.type != pe->atom_Blank)
+      continue;
+    obj = (const LV2_Atom_Object *)&ev->body;
+    if (obj->body.otype != pe->patch_Set)
+      continue;
+    property = atom = NULL;
+    lv2_atom_object_get(obj, pe->patch_property, &property,
+                        pe->patch_value, &atom, 0);
+    if (!property || property->type != pe->atom_URID || !atom)
+      continue;
+    for (l1 = 0; l1 < PARAM_COUNT; l1++)
+      if (((const LV2_Atom_URID *)property)->body == pe->param[l1])
+        break;
+    if (l1 == PARAM_COUNT)
+      continue;
+    if (atom->type == pe->atom_Float)
+      *value = ((const LV2_Atom_Float *)atom)->body;
+    else if (atom->type == pe->atom_Double)
+      *value = ((const LV2_Atom_Double *)atom)->body;
+    else
+      continue;
+    *index = l1;
+    return (ev->time.frames < sample_count)
+        ? (uint32_t)ev->time.frames : sample_count;
+  }
+  pe->next = NULL;
+  return sample_count;
+}
+
+/*  Set parameter index to value from an event, remembering the port
+    value it stands in for.
+*/
+static inline void paramSet(paramEvents *pe, float *const *ports,
+    float *values, int index, float value)
+{
+  values[index] = value;
+  pe->value[index] = value;
+  pe->port[index] = ports[index] ? *(ports[index]) : 0;
+  pe->set[index] = 1;
+}
+
+#endif
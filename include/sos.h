@@ -0,0 +1,440 @@
+#ifndef SOS_H
+#define SOS_H
+
+/*  Cascades of up to SOS_MAX_SECTIONS RBJ biquads for the higher-order
+    slopes of lowpass, highpass, bandpass2 and notch.
+
+    All sections are designed at once from one set of filter parameters:
+    the resonant response stacks identical sections at the resonance
+    control, Butterworth and Linkwitz-Riley use the section Qs of their
+    analog prototypes and ignore it.  The plugin gain goes into the first
+    section.  The state of section s is kept at buf + 4 * s in the layout
+    of biquad.h, so a one-section cascade runs on the same state as the
+    plain biquad.
+
+    The sections are run as a wavefront across the lanes of one vector:
+    at step t lane s filters sample t - s, taking the output lane s - 1
+    produced at step t - 1.  The lanes are independent within a step, so
+    a step costs the latency of one biquad whatever the number of
+    sections, where a plain cascade would chain them.  The first and last
+    sections - 1 steps of a run, where some lanes have no sample, are run
+    per section.  The intermediate outputs stay in double.
+
+    sosBandsRun() chains up to SOS_MAX_BANDS independently designed
+    biquads, the bands of an EQ, through such cascades.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "biquad.h"
+
+/* sosRun() holds the lanes in two vectors of two, so this is fixed at 4 */
+#define SOS_MAX_SECTIONS       4
+#define SOS_MAX_BANDS         32
+#define SOS_BAND_CHUNKS        (SOS_MAX_BANDS / SOS_MAX_SECTIONS)
+#define SOS_TILE             256
+
+enum {
+  SOS_RESONANT,
+  SOS_BUTTERWORTH,
+  SOS_LINKWITZ_RILEY
+};
+
+typedef struct {
+  biquadCoefs section[SOS_MAX_SECTIONS];
+  uint32_t sections;
+  int response;
+} sosCascade;
+
+/*  The lanes are held in two vectors of two, which every target keeps in
+    registers; wider vectors are built through memory without AVX and stall
+    the recursion on store forwarding.  SOS_PICK(a, b, i, j) takes lane i
+    and lane j of the four lanes of a and b.
+*/
+typedef double sosHalf __attribute__((vector_size(2 * sizeof(double))));
+
+#if defined(__clang__)
+#define SOS_PICK(a, b, i, j)   __builtin_shufflevector(a, b, i, j)
+#else
+typedef long long sosMask __attribute__((vector_size(2 * sizeof(long long))));
+#define SOS_PICK(a, b, i, j)   __builtin_shuffle(a, b, (sosMask){ i, j })
+#endif
+
+/*  Section Qs for 1 to SOS_MAX_SECTIONS sections, lowest first.  The
+    Linkwitz-Riley filter of order 2n is the Butterworth filter of order n
+    squared, the odd orders contributing a double real pole (Q 1/2).
+*/
+static const double sos_butterworth_q[SOS_MAX_SECTIONS][SOS_MAX_SECTIONS] = {
+  { 0.70710678 },
+  { 0.54119610, 1.30656296 },
+  { 0.51763809, 0.70710678, 1.93185165 },
+  { 0.50979558, 0.60134489, 0.89997622, 2.56291545 }
+};
+
+static const double sos_linkwitz_riley_q[SOS_MAX_SECTIONS][SOS_MAX_SECTIONS] = {
+  { 0.5 },
+  { 0.70710678, 0.70710678 },
+  { 0.5, 1.0, 1.0 },
+  { 0.54119610, 1.30656296, 0.54119610, 1.30656296 }
+};
+
+/* Number of sections selected on a slope or order port, 1 when absent */
+static inline uint32_t sosSections(const float *port)
+{
+  if (!port || *port < 1.5f)
+    return 1;
+  if (*port > SOS_MAX_SECTIONS)
+    return SOS_MAX_SECTIONS;
+  return (uint32_t)(*port + 0.5f);
+}
+
+static inline int sosResponse(const float *port)
+{
+  if (!port || *port < 0.5f)
+    return SOS_RESONANT;
+  return (*port < 1.5f) ? SOS_BUTTERWORTH : SOS_LINKWITZ_RILEY;
+}
+
+static inline void sosInit(sosCascade *c)
+{
+  c->sections = 1;
+  c->response = SOS_RESONANT;
+}
+
+/*  Select the number of sections and the response; nonzero if either
+    changed, in which case the coefficients have to be designed again.
+    The state of the sections dropped is cleared, so sections that are
+    added later start from rest.
+*/
+static inline int sosSelect(sosCascade *c, double *buf, uint32_t sections,
+    int response)
+{
+  if (sections == c->sections && response == c->response)
+    return 0;
+  memset(buf + 4 * sections, 0,
+         4 * (SOS_MAX_SECTIONS - sections) * sizeof(double));
+  c->sections = sections;
+  c->response = response;
+  return 1;
+}
+
+/*  Design the selected sections from the parameters of
+    rbjControlParams() or rbjCVParams().  rbjCoefs() takes the resonance
+    control q, which maps to Q as Q_SCALE * q / 2.  type is expected to
+    be a constant.
+*/
+static inline void sosDesign(sosCascade *c, int type, double iv_sin,
+    double iv_cos, double q, double gain)
+{
+  uint32_t sections = c->sections;
+  const double *proto_q = (c->response == SOS_BUTTERWORTH)
+      ? sos_butterworth_q[sections - 1]
+      : sos_linkwitz_riley_q[sections - 1];
+  uint32_t l1;
+  if (c->response == SOS_RESONANT) {
+    rbjCoefs(&c->section[0], type, iv_sin, iv_cos, q, 1.0, gain);
+    if (sections > 1)
+      rbjCoefs(&c->section[1], type, iv_sin, iv_cos, q, 1.0, 1.0);
+    for (l1 = 2; l1 < sections; l1++)
+      c->section[l1] = c->section[1];
+    return;
+  }
+  for (l1 = 0; l1 < sections; l1++)
+    rbjCoefs(&c->section[l1], type, iv_sin, iv_cos,
+             proto_q[l1] * (2.0 / Q_SCALE), 1.0, l1 ? 1.0 : gain);
+}
+
+/*  The terms are summed so that only the last two depend on the step
+    before, see sosRun().
+*/
+static inline double sosTick(const biquadCoefs *c, double *buf, double in)
+{
+  double out = c->b1 * buf[0] + c->b2 * buf[1] - c->a2 * buf[3]
+      + c->b0 * in - c->a1 * buf[2];
+  buf[1] = buf[0];
+  buf[0] = in;
+  buf[3] = buf[2];
+  buf[2] = out;
+  return out;
+}
+
+/*  Step t of the wavefront, one section at a time: the lanes that have a
+    sample of [0, len), from the last one down so that each reads the
+    output its predecessor produced at step t - 1.
+*/
+static inline void sosStep(const sosCascade *c, double *buf,
+    const float *input, float *output, uint32_t len, uint32_t t)
+{
+  uint32_t last = c->sections - 1;
+  uint32_t lo = (t >= len) ? t - len + 1 : 0;
+  uint32_t s = (t < last) ? t : last;
+  double y;
+  for (;; s--) {
+    y = sosTick(&c->section[s], buf + 4 * s,
+                s ? buf[4 * (s - 1) + 2] : input[t]);
+    if (s == last)
+      output[t - last] = y;
+    if (s == lo)
+      break;
+  }
+}
+
+/*  Run len samples through the cascade with fixed coefficients.  Lanes
+    past the last section run an identity so the vector stays finite.
+*/
+static inline void sosRun(const sosCascade *c, double *buf,
+    const float *input, float *output, uint32_t len)
+{
+  sosHalf b0[2], b1[2], b2[2], a1[2], a2[2], x1[2], x2[2], y1[2], y2[2];
+  sosHalf x[2], y[2];
+  double lanes[9][SOS_MAX_SECTIONS];
+  uint32_t last = c->sections - 1;
+  uint32_t l1, t, h, k;
+  if (!len)
+    return;
+  for (t = 0; t < last; t++)
+    sosStep(c, buf, input, output, len, t);
+  if (t < len) {
+    for (l1 = 0; l1 < SOS_MAX_SECTIONS; l1++) {
+      const double *state = buf + 4 * ((l1 <= last) ? l1 : last);
+      lanes[0][l1] = (l1 <= last) ? c->section[l1].b0 : 1.0;
+      lanes[1][l1] = (l1 <= last) ? c->section[l1].b1 : 0;
+      lanes[2][l1] = (l1 <= last) ? c->section[l1].b2 : 0;
+      lanes[3][l1] = (l1 <= last) ? c->section[l1].a1 : 0;
+      lanes[4][l1] = (l1 <= last) ? c->section[l1].a2 : 0;
+      for (k = 0; k < 4; k++)
+        lanes[5 + k][l1] = state[k];
+    }
+    for (h = 0; h < 2; h++) {
+      b0[h] = (sosHalf){ lanes[0][2 * h], lanes[0][2 * h + 1] };
+      b1[h] = (sosHalf){ lanes[1][2 * h], lanes[1][2 * h + 1] };
+      b2[h] = (sosHalf){ lanes[2][2 * h], lanes[2][2 * h + 1] };
+      a1[h] = (sosHalf){ lanes[3][2 * h], lanes[3][2 * h + 1] };
+      a2[h] = (sosHalf){ lanes[4][2 * h], lanes[4][2 * h + 1] };
+      x1[h] = (sosHalf){ lanes[5][2 * h], lanes[5][2 * h + 1] };
+      x2[h] = (sosHalf){ lanes[6][2 * h], lanes[6][2 * h + 1] };
+      y1[h] = (sosHalf){ lanes[7][2 * h], lanes[7][2 * h + 1] };
+      y2[h] = (sosHalf){ lanes[8][2 * h], lanes[8][2 * h + 1] };
+    }
+    for (; t < len; t++) {
+      sosHalf in = { input[t], 0 };
+      x[0] = SOS_PICK(in, y1[0], 0, 2);
+      x[1] = SOS_PICK(y1[0], y1[1], 1, 2);
+      for (h = 0; h < 2; h++) {
+        y[h] = b1[h] * x1[h] + b2[h] * x2[h] - a2[h] * y2[h]
+            + b0[h] * x[h] - a1[h] * y1[h];
+        x2[h] = x1[h];
+        x1[h] = x[h];
+        y2[h] = y1[h];
+        y1[h] = y[h];
+      }
+      output[t - last] = y[last >> 1][last & 1];
+    }
+    for (l1 = 0; l1 <= last; l1++) {
+      h = l1 >> 1;
+      k = l1 & 1;
+      buf[4 * l1] = x1[h][k];
+      buf[4 * l1 + 1] = x2[h][k];
+      buf[4 * l1 + 2] = y1[h][k];
+      buf[4 * l1 + 3] = y2[h][k];
+    }
+  }
+  for (; t < len + last; t++)
+    sosStep(c, buf, input, output, len, t);
+}
+
+/* Nonzero if a band can be left out of sosBandsRun(), see biquadRunFixed() */
+static inline int sosBandIdentity(const biquadCoefs *c, const double *buf)
+{
+  double gain;
+  return biquadGain(c, &gain) && fabs(gain - 1.0) <= BIQUAD_GAIN_TOLERANCE
+      && biquadStateAtGain(buf[0], buf[1], buf[2], buf[3], 1.0);
+}
+
+/*  Bring the state of the bands that were left out up to date: each
+    holds the last two samples of the signal reaching it, the input or
+    the output of the band before, as biquadRunGain() would have.  in1
+    and in2 are the last two input samples.
+*/
+static inline void sosBandsSettle(double *buf, const int *active,
+    uint32_t bands, double in1, double in2, uint32_t sample_count)
+{
+  double x1 = in1, x2 = in2;
+  uint32_t l1;
+  for (l1 = 0; l1 < bands; l1++) {
+    double *state = buf + 4 * l1;
+    if (active[l1]) {
+      x1 = state[2];
+      x2 = state[3];
+      continue;
+    }
+    state[1] = (sample_count > 1) ? x2 : state[0];
+    state[0] = x1;
+    state[2] = state[0];
+    state[3] = state[1];
+  }
+}
+
+/*  Run sample_count samples through bands biquads in series, the state
+    of band b at buf + 4 * b, then apply gain.  Bands at unity gain whose
+    state has settled are identities and are left out; the others run as
+    sosRun() cascades of up to SOS_MAX_SECTIONS bands, SOS_TILE samples at
+    a time, so a tile stays in L1 from the first band to the last.  The
+    gain is applied after the last band, which keeps the state of every
+    band independent of it.
+*/
+static inline void sosBandsRun(const biquadCoefs *coefs, double *buf,
+    uint32_t bands, double gain, const float *input, float *output,
+    uint32_t sample_count)
+{
+  double in1, in2, state[SOS_BAND_CHUNKS][4 * SOS_MAX_SECTIONS];
+  sosCascade cascade[SOS_BAND_CHUNKS];
+  int active[SOS_MAX_BANDS];
+  uint32_t l1, l2, len, chunks, used = 0;
+  if (!sample_count)
+    return;
+  for (l1 = 0; l1 < bands; l1++) {
+    active[l1] = !sosBandIdentity(&coefs[l1], buf + 4 * l1);
+    if (!active[l1])
+      continue;
+    cascade[used / SOS_MAX_SECTIONS].section[used % SOS_MAX_SECTIONS] =
+        coefs[l1];
+    memcpy(state[used / SOS_MAX_SECTIONS] + 4 * (used % SOS_MAX_SECTIONS),
+           buf + 4 * l1, 4 * sizeof(double));
+    used++;
+  }
+  chunks = (used + SOS_MAX_SECTIONS - 1) / SOS_MAX_SECTIONS;
+  for (l2 = 0; l2 < chunks; l2++)
+    cascade[l2].sections = (used - l2 * SOS_MAX_SECTIONS < SOS_MAX_SECTIONS)
+        ? used - l2 * SOS_MAX_SECTIONS : SOS_MAX_SECTIONS;
+  in1 = input[sample_count - 1];
+  in2 = (sample_count > 1) ? input[sample_count - 2] : 0;
+  for (l1 = 0; l1 < sample_count; l1 += len) {
+    const float *in = input + l1;
+    float *out = output + l1;
+    len = sample_count - l1;
+    if (len > SOS_TILE)
+      len = SOS_TILE;
+    for (l2 = 0; l2 < chunks; l2++, in = out) {
+      if (cascade[l2].sections == 1)
+        biquadRun(&cascade[l2].section[0], state[l2], in, out, len);
+      else
+        sosRun(&cascade[l2], state[l2], in, out, len);
+    }
+    if (gain != 1.0) {
+      for (l2 = 0; l2 < len; l2++)
+        out[l2] = gain * in[l2];
+    }
+    else if (out != in) {
+      memcpy(out, in, len * sizeof(float));
+    }
+  }
+  for (l1 = 0, l2 = 0; l1 < bands; l1++)
+    if (active[l1]) {
+      memcpy(buf + 4 * l1,
+             state[l2 / SOS_MAX_SECTIONS] + 4 * (l2 % SOS_MAX_SECTIONS),
+             4 * sizeof(double));
+      l2++;
+    }
+  sosBandsSettle(buf, active, bands, in1, in2, sample_count);
+}
+
+/*  Run len samples through the cascade while moving the coefficients of
+    every section linearly onto those of target, as biquadRunRamp().  The
+    sections are chained a sample at a time, the intermediate outputs in
+    double; the coefficients change every sample, so there is no
+    wavefront to run.
+*/
+static inline void sosRunRamp(sosCascade *c, const sosCascade *target,
+    double *buf, const float *input, float *output, uint32_t len)
+{
+  biquadCoefs step[SOS_MAX_SECTIONS];
+  biquadCoefs *section;
+  uint32_t sections = c->sections;
+  uint32_t l1, s;
+  double inv_len, x;
+  if (!len)
+    return;
+  inv_len = 1.0 / len;
+  for (s = 0; s < sections; s++) {
+    step[s].b0 = (target->section[s].b0 - c->section[s].b0) * inv_len;
+    step[s].b1 = (target->section[s].b1 - c->section[s].b1) * inv_len;
+    step[s].b2 = (target->section[s].b2 - c->section[s].b2) * inv_len;
+    step[s].a1 = (target->section[s].a1 - c->section[s].a1) * inv_len;
+    step[s].a2 = (target->section[s].a2 - c->section[s].a2) * inv_len;
+  }
+  for (l1 = 0; l1 < len; l1++) {
+    x = input[l1];
+    for (s = 0; s < sections; s++) {
+      section = &c->section[s];
+      section->b0 += step[s].b0;
+      section->b1 += step[s].b1;
+      section->b2 += step[s].b2;
+      section->a1 += step[s].a1;
+      section->a2 += step[s].a2;
+      x = sosTick(section, buf + 4 * s, x);
+    }
+    output[l1] = x;
+  }
+  for (s = 0; s < sections; s++)
+    c->section[s] = target->section[s];
+}
+
+/* Design the cascade for sample i of a CV block */
+static inline void sosCVDesign(sosCascade *c, int type, int conn,
+    const rbjCV *cv, uint32_t i)
+{
+  double iv_sin, iv_cos, q, A;
+  rbjCVParams(type, conn, cv, i, &iv_sin, &iv_cos, &q, &A);
+  sosDesign(c, type, iv_sin, iv_cos, q, cv->gain);
+}
+
+/*  run() of a _cv instance with more than a plain biquad selected, as
+    rbjCVRun(): the cascade is designed once when no CV is connected,
+    else per run of constant CV values at mod_step 1, or ramped between
+    every mod_step samples, see sosRunRamp().  *coefs_valid says whether
+    the coefficients of c are those of the end of the last block.  Idle
+    blocks are skipped, see runSilent().  type and conn are expected to
+    be constants.
+*/
+static inline void sosCVRun(const rbjCV *cv, int type, int conn,
+    sosCascade *c, int *coefs_valid, double *buf, const float *input,
+    float *output, uint32_t sample_count, uint32_t mod_step)
+{
+  sosCascade target;
+  uint32_t l1, len;
+  if (runSilent(input, output, buf, 4 * c->sections, sample_count)) {
+    *coefs_valid = 0;
+    return;
+  }
+  if (!conn || mod_step == 1)
+    *coefs_valid = 0;
+  if (!conn) {
+    sosCVDesign(c, type, conn, cv, 0);
+    sosRun(c, buf, input, output, sample_count);
+  }
+  else if (mod_step > 1) {
+    if (!*coefs_valid)
+      sosCVDesign(c, type, conn, cv, 0);
+    *coefs_valid = 1;
+    target = *c;
+    for (l1 = 0; l1 < sample_count; l1 += len) {
+      len = sample_count - l1;
+      if (len > mod_step)
+        len = mod_step;
+      sosCVDesign(&target, type, conn, cv, l1 + len - 1);
+      sosRunRamp(c, &target, buf, input + l1, output + l1, len);
+    }
+  }
+  else {
+    for (l1 = 0; l1 < sample_count; l1 += len) {
+      len = cvRunLength(conn, cv->freq_in, cv->reso_in, cv->dBgain_in,
+                        l1, sample_count);
+      sosCVDesign(c, type, conn, cv, l1);
+      sosRun(c, buf, input + l1, output + l1, len);
+    }
+  }
+}
+
+#endif
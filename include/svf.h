@@ -0,0 +1,159 @@
+#ifndef SVF_H
+#define SVF_H
+
+/*  Zero-delay-feedback state variable filter (trapezoidal integration,
+    after Andrew Simper), the engine of the _svf descriptors.
+
+    With g = tan(pi * f / rate) and k = 1 / Q, one step is
+
+        v3 = v0 - ic2eq
+        v1 = a1 * ic1eq + a2 * v3           band
+        v2 = ic2eq + a2 * ic1eq + a3 * v3   low
+        ic1eq = 2 * v1 - ic1eq
+        ic2eq = 2 * v2 - ic2eq
+
+    and out = m0 * v0 + m1 * v1 + m2 * v2 picks the response.  The mix
+    reproduces the bilinear transform of the same analog prototypes as the
+    RBJ formulas, so with fixed settings an _svf instance sounds like the
+    biquad one.  The state holds the integrator charges rather than past
+    outputs, which keeps it stable and free of zipper noise when the
+    coefficients change every sample.  g is never formed: svfCoefsSet()
+    folds it into the one division a new cutoff costs.
+*/
+
+#include <stdint.h>
+#include <math.h>
+
+#include "biquad.h"
+
+typedef struct {
+  double a1, a2, a3, m0, m1, m2, k;
+} svfCoefs;
+
+/*  Coefficients from the parameters of rbjCVParams(): sin and cos of the
+    normalised cutoff, the resonance control q and the amplitude A.  The
+    resonance maps to Q as in rbjCoefs(): Q_SCALE * q / 2 for the pass,
+    notch and peak filters, q for the shelves.  The shelves move the cutoff
+    by r = sqrt(A) or 1 / sqrt(A); with g = r * tan(w / 2) and
+    sin^2 = (1 - cos) * (1 + cos) the common denominator becomes
+
+        d = (1 + cos) + r^2 * (1 - cos) + r * k * sin
+
+    so that a1 = (1 + cos) / d, a2 = r * sin / d, a3 = r^2 * (1 - cos) / d
+    cost a single division.
+*/
+static inline void svfCoefsSet(svfCoefs *c, int type, double iv_sin,
+    double iv_cos, double q, double A, double gain)
+{
+  double k, r = 1, m0 = 0, m1 = 0, m2 = 0, inv_d;
+  switch (type) {
+  case RBJ_LOWPASS:
+    k = 2.0 / (Q_SCALE * q);
+    m2 = 1;
+    break;
+  case RBJ_HIGHPASS:
+    k = 2.0 / (Q_SCALE * q);
+    m0 = 1;
+    m1 = -k;
+    m2 = -1;
+    break;
+  case RBJ_BANDPASS1:
+    k = 2.0 / (Q_SCALE * q);
+    m1 = q * k;
+    break;
+  case RBJ_BANDPASS2:
+    k = 2.0 / (Q_SCALE * q);
+    m1 = k;
+    break;
+  case RBJ_NOTCH:
+    k = 2.0 / (Q_SCALE * q);
+    m0 = 1;
+    m1 = -k;
+    break;
+  case RBJ_PEAK_EQ:
+    k = 2.0 / (Q_SCALE * q * A);
+    m0 = 1;
+    m1 = k * (A * A - 1.0);
+    break;
+  case RBJ_LOW_SHELF:
+    k = 1.0 / q;
+    r = 1.0 / sqrt(A);
+    m0 = 1;
+    m1 = k * (A - 1.0);
+    m2 = A * A - 1.0;
+    break;
+  default:
+    k = 1.0 / q;
+    r = sqrt(A);
+    m0 = A * A;
+    m1 = k * (1.0 - A) * A;
+    m2 = 1.0 - A * A;
+    break;
+  }
+  inv_d = 1.0 / ((1.0 + iv_cos) + r * (r * (1.0 - iv_cos) + k * iv_sin));
+  c->a1 = (1.0 + iv_cos) * inv_d;
+  c->a2 = r * iv_sin * inv_d;
+  c->a3 = r * r * (1.0 - iv_cos) * inv_d;
+  c->m0 = gain * m0;
+  c->m1 = gain * m1;
+  c->m2 = gain * m2;
+  c->k = k;
+}
+
+/* Coefficients for sample i of an _svf block, see rbjCVParams() */
+static inline void svfCVCoefs(
+    svfCoefs *c, int type, int conn, const rbjCV *cv, uint32_t i)
+{
+  double iv_sin, iv_cos, q, A;
+  rbjCVParams(type, conn, cv, i, &iv_sin, &iv_cos, &q, &A);
+  svfCoefsSet(c, type, iv_sin, iv_cos, q, A, cv->gain);
+}
+
+/*  One step of the core, leaving the band and low outputs in v1 and v2.
+    state[2] = { ic1eq, ic2eq }
+*/
+static inline void svfStep(const svfCoefs *c, double *state, double in,
+    double *v1, double *v2)
+{
+  double v3 = in - state[1];
+  *v1 = c->a1 * state[0] + c->a2 * v3;
+  *v2 = state[1] + c->a2 * state[0] + c->a3 * v3;
+  state[0] = 2.0 * *v1 - state[0];
+  state[1] = 2.0 * *v2 - state[1];
+}
+
+static inline float svfTick(const svfCoefs *c, double *state, float in)
+{
+  double v1, v2;
+  svfStep(c, state, in, &v1, &v2);
+  return c->m0 * in + c->m1 * v1 + c->m2 * v2;
+}
+
+/*  run() of an _svf instance: fixed coefficients when no CV is connected,
+    else coefficients per run of constant CV values, at audio rate.  Idle
+    blocks are skipped, see runSilent().  type and conn are expected to
+    be constants.
+*/
+static inline void svfCVRun(const rbjCV *cv, int type, int conn,
+    double *state, const float *input, float *output, uint32_t sample_count)
+{
+  svfCoefs c;
+  uint32_t l1, l2, len;
+  if (runSilent(input, output, state, 2, sample_count))
+    return;
+  if (!conn) {
+    svfCVCoefs(&c, type, conn, cv, 0);
+    for (l1 = 0; l1 < sample_count; l1++)
+      output[l1] = svfTick(&c, state, input[l1]);
+    return;
+  }
+  for (l1 = 0; l1 < sample_count; l1 += len) {
+    len = cvRunLength(conn, cv->freq_in, cv->reso_in, cv->dBgain_in,
+                      l1, sample_count);
+    svfCVCoefs(&c, type, conn, cv, l1);
+    for (l2 = l1; l2 < l1 + len; l2++)
+      output[l2] = svfTick(&c, state, input[l2]);
+  }
+}
+
+#endif
@@ -1,6 +1,13 @@
 #ifndef VCF_H
 #define VCF_H
 
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#if defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#endif
+
 #define MIN_FREQ              20
 #define MAX_FREQ           20000
 #define Q_MIN              0.001
@@ -9,5 +16,343 @@
 #define DBGAIN_MAX          24.0 
 #define DBGAIN_SCALE         5.0
 #define Q_SCALE             32.0
+#define MOD_RATE_MAX          32
+#define CONTROLS_MAX           5
+#define CONTROL_TOLERANCE   1e-6
+#define CV_SCAN_CHUNK         16
+#define DENORMAL_LIMIT     1e-30
+#define SILENCE_LIMIT      1e-10
+#define BYPASS_FADE          256
+
+/* Clone the run functions of the lane and block kernels for AVX2 with
+   FMA where the toolchain can dispatch at load time, with their callees
+   inlined so the kernels are compiled for each target; elsewhere they
+   are plain C left to the auto-vectoriser. */
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__ELF__)
+#define VCF_SIMD \
+  __attribute__((target_clones("arch=haswell", "default"), flatten))
+#else
+#define VCF_SIMD
+#endif
+
+/*  Flush-to-zero and denormals-are-zero for the duration of run().  Once
+    the input goes silent the filter state decays towards zero and would
+    spend most of the tail as subnormals, which cost an assist per
+    operation on x86.  denormalsOff() returns the previous floating point
+    mode for denormalsRestore(), so the host's own setting survives the
+    call.  flushDenormals() is applied to the state at the end of each
+    run() as well, for targets without such a mode.
+*/
+#if defined(__SSE__) || defined(__x86_64__)
+typedef unsigned int fpuMode;
+
+static inline fpuMode denormalsOff(void)
+{
+  fpuMode mode = _mm_getcsr();
+  _mm_setcsr(mode | 0x8040);
+  return mode;
+}
+
+static inline void denormalsRestore(fpuMode mode)
+{
+  _mm_setcsr(mode);
+}
+#elif defined(__aarch64__) && defined(__GNUC__)
+typedef uint64_t fpuMode;
+
+static inline fpuMode denormalsOff(void)
+{
+  fpuMode mode;
+  __asm__ __volatile__("mrs %0, fpcr" : "=r"(mode));
+  __asm__ __volatile__("msr fpcr, %0" : : "r"(mode | (UINT64_C(1) << 24)));
+  return mode;
+}
+
+static inline void denormalsRestore(fpuMode mode)
+{
+  __asm__ __volatile__("msr fpcr, %0" : : "r"(mode));
+}
+#else
+typedef int fpuMode;
+
+static inline fpuMode denormalsOff(void)
+{
+  return 0;
+}
+
+static inline void denormalsRestore(fpuMode mode)
+{
+  (void)mode;
+}
+#endif
+
+/*  Zero the values of state that have decayed below DENORMAL_LIMIT, far
+    under the resolution of the float output; nonzero if any had to be.
+    The caller adds the result to the denormal_flushes counter of the
+    instance, which counts the run() calls that had to flush.  It is not
+    a port; read it from a debugger on a running instance, e.g.
+
+        print ((filtType2 *)instance)->denormal_flushes
+
+    A count that keeps rising on silent input means runSilent() does not
+    catch the tail.  make check runs tests/decay, which measures the cost
+    of the tails instead.
+*/
+static inline uint32_t flushDenormals(double *state, uint32_t count)
+{
+  uint32_t l1, flushed = 0;
+  for (l1 = 0; l1 < count; l1++) {
+    if (state[l1] != 0 && fabs(state[l1]) < DENORMAL_LIMIT) {
+      state[l1] = 0;
+      flushed = 1;
+    }
+  }
+  return flushed;
+}
+
+/* Nonzero if in holds 0 for all count samples */
+static inline int blockZero(const float *in, uint32_t count)
+{
+  uint32_t l1 = 0, l2;
+  int nonzero = 0;
+  for (; l1 + CV_SCAN_CHUNK <= count; l1 += CV_SCAN_CHUNK) {
+    for (l2 = l1; l2 < l1 + CV_SCAN_CHUNK; l2++)
+      nonzero |= (in[l2] != 0);
+    if (nonzero)
+      return 0;
+  }
+  for (; l1 < count; l1++)
+    nonzero |= (in[l1] != 0);
+  return !nonzero;
+}
+
+/* Nonzero if every value of state is below SILENCE_LIMIT in magnitude */
+static inline int stateDecayed(const double *state, uint32_t count)
+{
+  uint32_t l1;
+  int live = 0;
+  for (l1 = 0; l1 < count; l1++)
+    live |= (fabs(state[l1]) >= SILENCE_LIMIT);
+  return !live;
+}
+
+/*  Skip a block of an idle filter: when the input is all zeros and the
+    tail has decayed below SILENCE_LIMIT (-200 dB), the state is cleared
+    and the output filled with zeros instead of running the recursion.
+    Returns nonzero if it did so; the first block with a non-zero sample
+    is processed normally, starting from rest.
+*/
+static inline int runSilent(const float *input, float *output,
+    double *state, uint32_t state_count, uint32_t sample_count)
+{
+  if (!blockZero(input, sample_count)
+      || !stateDecayed(state, state_count))
+    return 0;
+  memset(state, 0, state_count * sizeof(double));
+  memset(output, 0, sample_count * sizeof(float));
+  return 1;
+}
+
+/*  State of the lv2:enabled port.  Toggling it crossfades between the
+    filter and a plain copy of the input over BYPASS_FADE samples; once
+    bypassed the filter is not run at all, so its state is kept as it was
+    for the fade back in.  wet counts the position of the fade, from 0
+    (bypassed) to BYPASS_FADE (enabled), and dry holds the input samples
+    of the fade in the current block, which the filter may overwrite when
+    it runs in place.
+*/
+typedef struct {
+  float *enabled;
+  uint32_t wet, fade;
+  int target;
+  float dry[BYPASS_FADE];
+} bypassFade;
+
+static inline void bypassInit(bypassFade *bypass)
+{
+  bypass->enabled = NULL;
+  bypass->wet = BYPASS_FADE;
+  bypass->fade = 0;
+  bypass->target = 1;
+}
+
+/*  Number of samples from the start of the block that the filter has to
+    be run for, 0 when it is bypassed.  Call bypassEnd() after running it.
+*/
+static inline uint32_t bypassBegin(bypassFade *bypass, const float *input,
+    float *output, uint32_t sample_count)
+{
+  uint32_t fade;
+  bypass->target = !bypass->enabled || *(bypass->enabled) > 0;
+  bypass->fade = 0;
+  if (bypass->target && bypass->wet == BYPASS_FADE)
+    return sample_count;
+  if (!bypass->target && bypass->wet == 0) {
+    if (output != input)
+      memcpy(output, input, sample_count * sizeof(float));
+    return 0;
+  }
+  fade = bypass->target ? BYPASS_FADE - bypass->wet : bypass->wet;
+  if (fade > sample_count)
+    fade = sample_count;
+  memcpy(bypass->dry, input, fade * sizeof(float));
+  bypass->fade = fade;
+  return bypass->target ? sample_count : fade;
+}
+
+/* Crossfade the output of the filter with the dry input */
+static inline void bypassEnd(bypassFade *bypass, const float *input,
+    float *output, uint32_t sample_count)
+{
+  uint32_t l1, fade = bypass->fade;
+  float wet, step = (bypass->target ? 1.0f : -1.0f) / BYPASS_FADE;
+  if (!fade)
+    return;
+  wet = (float)bypass->wet / BYPASS_FADE;
+  for (l1 = 0; l1 < fade; l1++) {
+    wet += step;
+    output[l1] = bypass->dry[l1] + wet * (output[l1] - bypass->dry[l1]);
+  }
+  if (bypass->target) {
+    bypass->wet += fade;
+  }
+  else {
+    bypass->wet -= fade;
+    if (output != input && fade < sample_count)
+      memcpy(output + fade, input + fade,
+             (sample_count - fade) * sizeof(float));
+  }
+}
+
+/*  Control port values the coefficients of an instance were last
+    computed from.  A value only counts as changed when it moves by more
+    than CONTROL_TOLERANCE relative to the cached one, so host rounding
+    jitter does not force a recomputation; slow ramps still get through
+    once they have moved far enough from the cached value.
+*/
+typedef struct {
+  float value[CONTROLS_MAX];
+  int valid;
+} controlCache;
+
+/* Compare values with the cache and update it; nonzero if they changed */
+static inline int controlsChanged(
+    controlCache *cache, const float *values, int count)
+{
+  int l1;
+  if (cache->valid) {
+    for (l1 = 0; l1 < count; l1++)
+      if (fabsf(values[l1] - cache->value[l1])
+          > CONTROL_TOLERANCE * fabsf(cache->value[l1]))
+        break;
+    if (l1 == count)
+      return 0;
+  }
+  for (l1 = 0; l1 < count; l1++)
+    cache->value[l1] = values[l1];
+  cache->valid = 1;
+  return 1;
+}
+
+/*  Connected CV inputs of a _cv instance.  Each combination gets its own
+    copy of the run function, compiled with the connections as constants
+    so that the sample loops carry no NULL tests; run() picks the copy for
+    the inputs that modulate the block, see cvActiveConnections().
+*/
+enum {
+  CV_FREQ    = 1,
+  CV_RESO    = 2,
+  CV_DBGAIN  = 4,
+  CV_KERNELS = 8
+};
+
+typedef void (*cvKernel)(void *instance, uint32_t sample_count);
+
+/*  Connected CV inputs that modulate a block of count samples.  An input
+    holding 0 for the whole block adds nothing to its offset, so hosts
+    that feed silence into every CV port get the constant-coefficient
+    kernel until modulation arrives.
+*/
+static inline int cvActiveConnections(const float *freq_in,
+    const float *reso_in, const float *dBgain_in, uint32_t count)
+{
+  return ((freq_in && !blockZero(freq_in, count)) ? CV_FREQ : 0)
+      | ((reso_in && !blockZero(reso_in, count)) ? CV_RESO : 0)
+      | ((dBgain_in && !blockZero(dBgain_in, count)) ? CV_DBGAIN : 0);
+}
+
+/*  Number of samples from first on, at least 1 and at most
+    count - first, over which every connected CV input keeps its value at
+    first.  Short runs are found sample by sample; past CV_SCAN_CHUNK the
+    scan goes a chunk at a time with compares that vectorise.  conn is
+    expected to be a constant.
+*/
+static inline uint32_t cvRunLength(int conn, const float *freq_in,
+    const float *reso_in, const float *dBgain_in, uint32_t first,
+    uint32_t count)
+{
+  float freq = (conn & CV_FREQ) ? freq_in[first] : 0;
+  float reso = (conn & CV_RESO) ? reso_in[first] : 0;
+  float dBgain = (conn & CV_DBGAIN) ? dBgain_in[first] : 0;
+  uint32_t end = first + 1, l1;
+  int diff;
+#define CV_DIFFERS(i) \
+  (((conn & CV_FREQ) && freq_in[i] != freq) \
+   | ((conn & CV_RESO) && reso_in[i] != reso) \
+   | ((conn & CV_DBGAIN) && dBgain_in[i] != dBgain))
+  for (; end < count && end < first + CV_SCAN_CHUNK; end++)
+    if (CV_DIFFERS(end))
+      return end - first;
+  for (; end + CV_SCAN_CHUNK <= count; end += CV_SCAN_CHUNK) {
+    diff = 0;
+    for (l1 = end; l1 < end + CV_SCAN_CHUNK; l1++)
+      diff |= CV_DIFFERS(l1);
+    if (diff)
+      break;
+  }
+  for (; end < count; end++)
+    if (CV_DIFFERS(end))
+      break;
+#undef CV_DIFFERS
+  return end - first;
+}
+
+/*  Define kernels[CV_KERNELS], where kernels[conn] calls
+    run(instance, sample_count, conn) with conn a constant and denormals
+    off.  Filters without a dBgain_in CV use CV_KERNELS_NO_DBGAIN, which
+    only compiles the freq_in and reso_in combinations.
+*/
+#define CV_KERNEL(kernels, run, conn) \
+  static VCF_SIMD void kernels##_##conn( \
+      void *instance, uint32_t sample_count) \
+  { \
+    fpuMode mode = denormalsOff(); \
+    run(instance, sample_count, conn); \
+    denormalsRestore(mode); \
+  }
+
+#define CV_KERNELS(kernels, run) \
+  CV_KERNEL(kernels, run, 0) \
+  CV_KERNEL(kernels, run, 1) \
+  CV_KERNEL(kernels, run, 2) \
+  CV_KERNEL(kernels, run, 3) \
+  CV_KERNEL(kernels, run, 4) \
+  CV_KERNEL(kernels, run, 5) \
+  CV_KERNEL(kernels, run, 6) \
+  CV_KERNEL(kernels, run, 7) \
+  static const cvKernel kernels[CV_KERNELS] = { \
+    kernels##_0, kernels##_1, kernels##_2, kernels##_3, \
+    kernels##_4, kernels##_5, kernels##_6, kernels##_7 \
+  };
+
+#define CV_KERNELS_NO_DBGAIN(kernels, run) \
+  CV_KERNEL(kernels, run, 0) \
+  CV_KERNEL(kernels, run, 1) \
+  CV_KERNEL(kernels, run, 2) \
+  CV_KERNEL(kernels, run, 3) \
+  static const cvKernel kernels[CV_KERNELS] = { \
+    kernels##_0, kernels##_1, kernels##_2, kernels##_3, \
+    kernels##_0, kernels##_1, kernels##_2, kernels##_3 \
+  };
 
 #endif
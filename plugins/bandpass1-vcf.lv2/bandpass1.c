@@ -9,12 +9,32 @@
 
 #include "vcf.h"
 #include "filter_type2.h"
+#include "filter_multi.h"
+#include "filter_voices.h"
+#include "filter_svf.h"
 
-#define BANDPASS1_URI   "http://jwm-art.net/lv2/vcf/bandpass1";
-#define BANDPASS1CV_URI "http://jwm-art.net/lv2/vcf/bandpass1_cv";
+#define BANDPASS1_URI    "http://jwm-art.net/lv2/vcf/bandpass1";
+#define BANDPASS1CV_URI  "http://jwm-art.net/lv2/vcf/bandpass1_cv";
+#define BANDPASS1SVF_URI "http://jwm-art.net/lv2/vcf/bandpass1_svf";
 
 static LV2_Descriptor *Bandpass1Descriptor = NULL;
 static LV2_Descriptor *Bandpass1CVDescriptor = NULL;
+static LV2_Descriptor *Bandpass1SVFDescriptor = NULL;
+static LV2_Descriptor *Bandpass1MultiDescriptor[MULTI_DESCRIPTORS];
+static LV2_Descriptor *Bandpass1VoicesDescriptor[VOICES_DESCRIPTORS];
+
+static const char *Bandpass1MultiURI[MULTI_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/bandpass1_x2",
+    "http://jwm-art.net/lv2/vcf/bandpass1_x8",
+    "http://jwm-art.net/lv2/vcf/bandpass1_x16",
+    "http://jwm-art.net/lv2/vcf/bandpass1_x64"
+};
+
+static const char *Bandpass1VoicesURI[VOICES_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/bandpass1_voices8",
+    "http://jwm-art.net/lv2/vcf/bandpass1_voices16",
+    "http://jwm-art.net/lv2/vcf/bandpass1_voices32"
+};
 
 typedef filtType2    Bandpass1;
 typedef filtType2_cv Bandpass1CV;
@@ -35,6 +55,8 @@ static void connectPortBandpass1(
         case 3: plugin->freq_ofs = data;    break;
         case 4: plugin->freq_pitch = data;  break;
         case 5: plugin->reso_ofs = data;    break;
+        case 6: plugin->bypass.enabled = data; break;
+        case 7: plugin->params.control = data; break;
     }
 }
 
@@ -46,6 +68,13 @@ static LV2_Handle instantiateBandpass1(
 {
     Bandpass1* plugin_data = (Bandpass1*)malloc(sizeof(Bandpass1));
     plugin_data->rate = s_rate;
+    plugin_data->controls.valid = 0;
+    plugin_data->sections = NULL;
+    plugin_data->response = NULL;
+    sosInit(&plugin_data->sos);
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    paramEventsInit(&plugin_data->params, features);
     return (LV2_Handle)plugin_data;
 }
 
@@ -53,56 +82,18 @@ static void activateBandpass1(LV2_Handle instance)
 {
     Bandpass1 *plugin_data = (Bandpass1 *)instance;
     int l1;
-    for (l1 = 0; l1 < 4; l1++)
+    for (l1 = 0; l1 < 4 * SOS_MAX_SECTIONS; l1++)
       plugin_data->buf[l1] = 0;
 }
 
-static void runBandpass1(LV2_Handle instance, uint32_t sample_count)
+static VCF_SIMD void runBandpass1(LV2_Handle instance, uint32_t sample_count)
 {
-    int l1;
-    float out;
-    double f, q, pi2_rate;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha, inv_a0, a0, a1, a2, b0, b1, b2;
     Bandpass1 *pluginData = (Bandpass1 *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0) 
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f = *(pluginData->freq_ofs) * freq_pitch;
-    if (f < MIN_FREQ)
-        f = MIN_FREQ;
-    if (f > MAX_FREQ)
-        f = MAX_FREQ;
-    q = *(pluginData->reso_ofs);
-    if (q < Q_MIN)
-        q = Q_MIN;
-    if (q > Q_MAX)
-        q = Q_MAX;
-    iv_sin = sin(pi2_rate * f);
-    iv_cos = cos(pi2_rate * f);
-    iv_alpha = iv_sin/(Q_SCALE * q);
-    b0 = q * iv_alpha;
-    b1 = 0;
-    b2 = -q * iv_alpha;
-    a0 = 1.0 + iv_alpha;
-    a1 = -2.0 * iv_cos;
-    a2 = 1.0 - iv_alpha;
-    inv_a0 = 1.0 / a0;
-    for (l1 = 0; l1 < sample_count; l1++) {
-        out = inv_a0 * (gain
-            * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                - a1 * buf[2] - a2 * buf[3]);
-        buf[1] = buf[0];
-        buf[0] = input[l1];
-        buf[3] = buf[2];
-        buf[2] = output[l1] = out;
-    }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    runFiltType2(pluginData, count, RBJ_BANDPASS1);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initBandpass1()
@@ -121,9 +112,19 @@ static void initBandpass1()
 
 static void cleanupBandpass1CV(LV2_Handle instance)
 {
+    Bandpass1CV *plugin_data = (Bandpass1CV *)instance;
+    coefTableRelease(plugin_data->table);
     free(instance);
 }
 
+static inline void runBandpass1CVConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltType2CV((Bandpass1CV *)instance, sample_count, RBJ_BANDPASS1, conn);
+}
+
+CV_KERNELS_NO_DBGAIN(Bandpass1CVKernels, runBandpass1CVConn)
+
 static void connectPortBandpass1CV(
     LV2_Handle instance, uint32_t port, void *data)
 {
@@ -137,6 +138,10 @@ static void connectPortBandpass1CV(
         case 5: plugin->freq_in = data;     break;
         case 6: plugin->reso_ofs = data;    break;
         case 7: plugin->reso_in = data;     break;
+        case 8: plugin->mod_rate = data;    break;
+        case 9: plugin->bypass.enabled = data; break;
+        default: modSourceConnect(&plugin->mod, port - 10, data);
+                 break;
     }
 }
 
@@ -148,6 +153,19 @@ static LV2_Handle instantiateBandpass1CV(
 {
     Bandpass1CV* plugin_data = (Bandpass1CV*)malloc(sizeof(Bandpass1CV));
     plugin_data->rate = s_rate;
+    plugin_data->freq_in = NULL;
+    plugin_data->reso_in = NULL;
+    plugin_data->sections = NULL;
+    plugin_data->response = NULL;
+    sosInit(&plugin_data->sos);
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    modSourceInit(&plugin_data->mod, s_rate, features);
+    plugin_data->table = coefTableAcquire(s_rate);
+    if (!plugin_data->table) {
+        free(plugin_data);
+        return NULL;
+    }
     return (LV2_Handle)plugin_data;
 }
 
@@ -155,133 +173,24 @@ static void activateBandpass1CV(LV2_Handle instance)
 {
     Bandpass1CV *plugin_data = (Bandpass1CV *)instance;
     int l1;
-    for (l1 = 0; l1 < 4; l1++)
+    for (l1 = 0; l1 < 4 * SOS_MAX_SECTIONS; l1++)
       plugin_data->buf[l1] = 0;
+    plugin_data->coefs_valid = 0;
 }
 
 static void runBandpass1CV(LV2_Handle instance, uint32_t sample_count)
 {
-    int l1;
-    float out;
-    double f0, q0, f, q, pi2_rate;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha, inv_a0, a0, a1, a2, b0, b1, b2;
     Bandpass1CV *pluginData = (Bandpass1CV *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_ofs = *(pluginData->freq_ofs);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0) 
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-        float reso_ofs = *(pluginData->reso_ofs);
-    float *freq_in = pluginData->freq_in;
-    float *reso_in = pluginData->reso_in;
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f0 = freq_ofs;
-    q0 = reso_ofs;
-    if (!(freq_in || reso_in)) {
-        f = f0 * freq_pitch;
-        if (f < MIN_FREQ)
-            f = MIN_FREQ;
-        if (f > MAX_FREQ)
-            f = MAX_FREQ;
-        q = q0;
-        if (q < Q_MIN)
-            q = Q_MIN;
-        if (q > Q_MAX)
-            q = Q_MAX;
-        iv_sin = sin(pi2_rate * f);
-        iv_cos = cos(pi2_rate * f);
-        iv_alpha = iv_sin/(Q_SCALE * q);
-        b0 = q * iv_alpha;
-        b1 = 0;
-        b2 = -q * iv_alpha;
-        a0 = 1.0 + iv_alpha;
-        a1 = -2.0 * iv_cos;
-        a2 = 1.0 - iv_alpha;
-        inv_a0 = 1.0 / a0;
-        for (l1 = 0; l1 < sample_count; l1++) {
-            out = inv_a0 * (gain
-                * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                    - a1 * buf[2] - a2 * buf[3]);
-            buf[1] = buf[0];
-            buf[0] = input[l1];
-            buf[3] = buf[2];
-            buf[2] = output[l1] = out;
-        }
-    }
-    else {
-        if (!reso_in) {
-            q = q0; 
-            if (q < Q_MIN)
-                q = Q_MIN;
-            if (q > Q_MAX)
-                q = Q_MAX;
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in[l1] > 0)
-                    ? (freq_in[l1] * MAX_FREQ 
-                        + f0 - MIN_FREQ) * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                b0 = q * iv_alpha;
-                b1 = 0;
-                b2 = -q * iv_alpha;
-                a0 = 1.0 + iv_alpha;
-                a1 = -2.0 * iv_cos;
-                a2 = 1.0 - iv_alpha;
-                out = 1.0 / a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
-        else {
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in && (freq_in[l1] > 0))
-                    ? (freq_in[l1] * MAX_FREQ
-                        + f0 - MIN_FREQ) * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                q = q0  + reso_in[l1];
-                if (q < Q_MIN)
-                    q = Q_MIN;
-                if (q > Q_MAX)
-                    q = Q_MAX;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                b0 = q * iv_alpha;
-                b1 = 0;
-                b2 = -q * iv_alpha;
-                a0 = 1.0 + iv_alpha;
-                a1 = -2.0 * iv_cos;
-                a2 = 1.0 - iv_alpha;
-                inv_a0 = 1.0 / a0;
-                out = inv_a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    int conn;
+    if (count) {
+        conn = cvActiveConnections(pluginData->freq_in, pluginData->reso_in,
+                                   NULL, count);
+        Bandpass1CVKernels[conn](instance, count);
     }
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initBandpass1CV()
@@ -298,6 +207,99 @@ static void initBandpass1CV()
     Bandpass1CVDescriptor->extension_data =   NULL;
 }
 
+static LV2_Handle instantiateBandpass1Multi(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltMulti(descriptor, s_rate, Bandpass1MultiDescriptor, 0);
+}
+
+static VCF_SIMD void runBandpass1Multi(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltMulti((filtMulti *)instance, sample_count, RBJ_BANDPASS1);
+}
+
+static void initBandpass1Multi(int index)
+{
+    Bandpass1MultiDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    Bandpass1MultiDescriptor[index]->URI =              Bandpass1MultiURI[index];
+    Bandpass1MultiDescriptor[index]->activate =         activateFiltMulti;
+    Bandpass1MultiDescriptor[index]->cleanup =          cleanupFiltMulti;
+    Bandpass1MultiDescriptor[index]->connect_port =     connectPortFiltMulti;
+    Bandpass1MultiDescriptor[index]->deactivate =       NULL;
+    Bandpass1MultiDescriptor[index]->instantiate =      instantiateBandpass1Multi;
+    Bandpass1MultiDescriptor[index]->run =              runBandpass1Multi;
+    Bandpass1MultiDescriptor[index]->extension_data =   NULL;
+}
+
+static LV2_Handle instantiateBandpass1Voices(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltVoices(descriptor, s_rate,
+                                 Bandpass1VoicesDescriptor, 0);
+}
+
+static VCF_SIMD void runBandpass1Voices(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltVoices((filtVoices *)instance, sample_count, RBJ_BANDPASS1);
+}
+
+static void initBandpass1Voices(int index)
+{
+    Bandpass1VoicesDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    Bandpass1VoicesDescriptor[index]->URI =              Bandpass1VoicesURI[index];
+    Bandpass1VoicesDescriptor[index]->activate =         activateFiltVoices;
+    Bandpass1VoicesDescriptor[index]->cleanup =          cleanupFiltVoices;
+    Bandpass1VoicesDescriptor[index]->connect_port =     connectPortFiltVoices;
+    Bandpass1VoicesDescriptor[index]->deactivate =       NULL;
+    Bandpass1VoicesDescriptor[index]->instantiate =      instantiateBandpass1Voices;
+    Bandpass1VoicesDescriptor[index]->run =              runBandpass1Voices;
+    Bandpass1VoicesDescriptor[index]->extension_data =   NULL;
+}
+
+static inline void runBandpass1SVFConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltSVFConn((filtSVF *)instance, sample_count, RBJ_BANDPASS1, conn);
+}
+
+CV_KERNELS_NO_DBGAIN(Bandpass1SVFKernels, runBandpass1SVFConn)
+
+static LV2_Handle instantiateBandpass1SVF(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltSVF(s_rate, 0);
+}
+
+static void runBandpass1SVF(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltSVF((filtSVF *)instance, sample_count, Bandpass1SVFKernels);
+}
+
+static void initBandpass1SVF()
+{
+    Bandpass1SVFDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    Bandpass1SVFDescriptor->URI =              BANDPASS1SVF_URI;
+    Bandpass1SVFDescriptor->activate =         activateFiltSVF;
+    Bandpass1SVFDescriptor->cleanup =          cleanupFiltSVF;
+    Bandpass1SVFDescriptor->connect_port =     connectPortFiltSVF;
+    Bandpass1SVFDescriptor->deactivate =       NULL;
+    Bandpass1SVFDescriptor->instantiate =      instantiateBandpass1SVF;
+    Bandpass1SVFDescriptor->run =              runBandpass1SVF;
+    Bandpass1SVFDescriptor->extension_data =   NULL;
+}
+
 LV2_SYMBOL_EXPORT
 const LV2_Descriptor *lv2_descriptor(uint32_t index)
 {
@@ -310,6 +312,23 @@ const LV2_Descriptor *lv2_descriptor(uint32_t index)
             if (!Bandpass1CVDescriptor)
                 initBandpass1CV();
             return Bandpass1CVDescriptor;
+        case 2:
+        case 3:
+        case 4:
+        case 5:
+            if (!Bandpass1MultiDescriptor[index - 2])
+                initBandpass1Multi(index - 2);
+            return Bandpass1MultiDescriptor[index - 2];
+        case 6:
+        case 7:
+        case 8:
+            if (!Bandpass1VoicesDescriptor[index - 6])
+                initBandpass1Voices(index - 6);
+            return Bandpass1VoicesDescriptor[index - 6];
+        case 9:
+            if (!Bandpass1SVFDescriptor)
+                initBandpass1SVF();
+            return Bandpass1SVFDescriptor;
     }
     return NULL;
 }
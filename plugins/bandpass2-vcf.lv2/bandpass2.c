@@ -9,12 +9,32 @@
 
 #include "vcf.h"
 #include "filter_type2.h"
+#include "filter_multi.h"
+#include "filter_voices.h"
+#include "filter_svf.h"
 
-#define BANDPASS2_URI   "http://jwm-art.net/lv2/vcf/bandpass2";
-#define BANDPASS2CV_URI "http://jwm-art.net/lv2/vcf/bandpass2_cv";
+#define BANDPASS2_URI    "http://jwm-art.net/lv2/vcf/bandpass2";
+#define BANDPASS2CV_URI  "http://jwm-art.net/lv2/vcf/bandpass2_cv";
+#define BANDPASS2SVF_URI "http://jwm-art.net/lv2/vcf/bandpass2_svf";
 
 static LV2_Descriptor *Bandpass2Descriptor = NULL;
 static LV2_Descriptor *Bandpass2CVDescriptor = NULL;
+static LV2_Descriptor *Bandpass2SVFDescriptor = NULL;
+static LV2_Descriptor *Bandpass2MultiDescriptor[MULTI_DESCRIPTORS];
+static LV2_Descriptor *Bandpass2VoicesDescriptor[VOICES_DESCRIPTORS];
+
+static const char *Bandpass2MultiURI[MULTI_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/bandpass2_x2",
+    "http://jwm-art.net/lv2/vcf/bandpass2_x8",
+    "http://jwm-art.net/lv2/vcf/bandpass2_x16",
+    "http://jwm-art.net/lv2/vcf/bandpass2_x64"
+};
+
+static const char *Bandpass2VoicesURI[VOICES_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/bandpass2_voices8",
+    "http://jwm-art.net/lv2/vcf/bandpass2_voices16",
+    "http://jwm-art.net/lv2/vcf/bandpass2_voices32"
+};
 
 typedef filtType2    Bandpass2;
 typedef filtType2_cv Bandpass2CV;
@@ -35,6 +55,9 @@ static void connectPortBandpass2(
         case 3: plugin->freq_ofs = data;    break;
         case 4: plugin->freq_pitch = data;  break;
         case 5: plugin->reso_ofs = data;    break;
+        case 6: plugin->sections = data;    break;
+        case 7: plugin->bypass.enabled = data; break;
+        case 8: plugin->params.control = data; break;
     }
 }
 
@@ -46,6 +69,13 @@ static LV2_Handle instantiateBandpass2(
 {
     Bandpass2* plugin_data = (Bandpass2*)malloc(sizeof(Bandpass2));
     plugin_data->rate = s_rate;
+    plugin_data->controls.valid = 0;
+    plugin_data->sections = NULL;
+    plugin_data->response = NULL;
+    sosInit(&plugin_data->sos);
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    paramEventsInit(&plugin_data->params, features);
     return (LV2_Handle)plugin_data;
 }
 
@@ -53,56 +83,18 @@ static void activateBandpass2(LV2_Handle instance)
 {
     Bandpass2 *plugin_data = (Bandpass2 *)instance;
     int l1;
-    for (l1 = 0; l1 < 4; l1++)
+    for (l1 = 0; l1 < 4 * SOS_MAX_SECTIONS; l1++)
       plugin_data->buf[l1] = 0;
 }
 
-static void runBandpass2(LV2_Handle instance, uint32_t sample_count)
+static VCF_SIMD void runBandpass2(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    float out;
-    double f, q, pi2_rate;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha, inv_a0, a0, a1, a2, b0, b1, b2;
     Bandpass2 *pluginData = (Bandpass2 *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-        : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f = *(pluginData->freq_ofs) * freq_pitch;
-    if (f < MIN_FREQ)
-        f = MIN_FREQ;
-    if (f > MAX_FREQ)
-        f = MAX_FREQ;
-    q = *(pluginData->reso_ofs);
-    if (q < Q_MIN)
-        q = Q_MIN;
-    if (q > Q_MAX)
-        q = Q_MAX;
-    iv_sin = sin(pi2_rate * f);
-    iv_cos = cos(pi2_rate * f);
-    iv_alpha = iv_sin/(Q_SCALE * q);
-    b0 = iv_alpha;
-    b1 = 0;
-    b2 = -iv_alpha;
-    a0 = 1.0 + iv_alpha;
-    a1 = -2.0 * iv_cos;
-    a2 = 1.0 - iv_alpha;
-    inv_a0 = 1.0 / a0;
-    for (l1 = 0; l1 < sample_count; l1++) {
-        out = inv_a0 * (gain
-            * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                - a1 * buf[2] - a2 * buf[3]);
-        buf[1] = buf[0];
-        buf[0] = input[l1];
-        buf[3] = buf[2];
-        buf[2] = output[l1] = out;
-    }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    runFiltType2(pluginData, count, RBJ_BANDPASS2);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initBandpass2()
@@ -121,9 +113,19 @@ static void initBandpass2()
 
 static void cleanupBandpass2CV(LV2_Handle instance)
 {
+    Bandpass2CV *plugin_data = (Bandpass2CV *)instance;
+    coefTableRelease(plugin_data->table);
     free(instance);
 }
 
+static inline void runBandpass2CVConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltType2CV((Bandpass2CV *)instance, sample_count, RBJ_BANDPASS2, conn);
+}
+
+CV_KERNELS_NO_DBGAIN(Bandpass2CVKernels, runBandpass2CVConn)
+
 static void connectPortBandpass2CV(
     LV2_Handle instance, uint32_t port, void *data)
 {
@@ -137,6 +139,11 @@ static void connectPortBandpass2CV(
         case 5: plugin->freq_in = data;     break;
         case 6: plugin->reso_ofs = data;    break;
         case 7: plugin->reso_in = data;     break;
+        case 8: plugin->mod_rate = data;    break;
+        case 9: plugin->sections = data;    break;
+        case 10: plugin->bypass.enabled = data; break;
+        default: modSourceConnect(&plugin->mod, port - 11, data);
+                 break;
     }
 }
 
@@ -148,6 +155,19 @@ static LV2_Handle instantiateBandpass2CV(
 {
     Bandpass2CV* plugin_data = (Bandpass2CV*)malloc(sizeof(Bandpass2CV));
     plugin_data->rate = s_rate;
+    plugin_data->freq_in = NULL;
+    plugin_data->reso_in = NULL;
+    plugin_data->sections = NULL;
+    plugin_data->response = NULL;
+    sosInit(&plugin_data->sos);
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    modSourceInit(&plugin_data->mod, s_rate, features);
+    plugin_data->table = coefTableAcquire(s_rate);
+    if (!plugin_data->table) {
+        free(plugin_data);
+        return NULL;
+    }
     return (LV2_Handle)plugin_data;
 }
 
@@ -155,133 +175,24 @@ static void activateBandpass2CV(LV2_Handle instance)
 {
     Bandpass2CV *plugin_data = (Bandpass2CV *)instance;
     int l1;
-    for (l1 = 0; l1 < 4; l1++)
+    for (l1 = 0; l1 < 4 * SOS_MAX_SECTIONS; l1++)
       plugin_data->buf[l1] = 0;
+    plugin_data->coefs_valid = 0;
 }
 
 static void runBandpass2CV(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    float out;
-    double f0, q0, f, q, pi2_rate;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha, inv_a0, a0, a1, a2, b0, b1, b2;
     Bandpass2CV *pluginData = (Bandpass2CV *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_ofs = *(pluginData->freq_ofs);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-        : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    float reso_ofs = *(pluginData->reso_ofs);
-    float *freq_in = pluginData->freq_in;
-    float *reso_in = pluginData->reso_in;
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f0 = freq_ofs;
-    q0 = reso_ofs;
-    if (!(freq_in || reso_in)) {
-        f = f0 * freq_pitch;
-        if (f < MIN_FREQ)
-            f = MIN_FREQ;
-        if (f > MAX_FREQ)
-            f = MAX_FREQ;
-        q = q0;
-        if (q < Q_MIN)
-            q = Q_MIN;
-        if (q > Q_MAX)
-            q = Q_MAX;
-        iv_sin = sin(pi2_rate * f);
-        iv_cos = cos(pi2_rate * f);
-        iv_alpha = iv_sin/(Q_SCALE * q);
-        b0 = iv_alpha;
-        b1 = 0;
-        b2 = -iv_alpha;
-        a0 = 1.0 + iv_alpha;
-        a1 = -2.0 * iv_cos;
-        a2 = 1.0 - iv_alpha;
-        inv_a0 = 1.0 / a0;
-        for (l1 = 0; l1 < sample_count; l1++) {
-            out = inv_a0 * (gain
-                * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                    - a1 * buf[2] - a2 * buf[3]);
-            buf[1] = buf[0];
-            buf[0] = input[l1];
-            buf[3] = buf[2];
-            buf[2] = output[l1] = out;
-        }
-    }
-    else {
-        if (!reso_in) {
-            q = q0;
-            if (q < Q_MIN)
-                q = Q_MIN;
-            if (q > Q_MAX)
-                q = Q_MAX;
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in[l1] > 0)
-                    ? (freq_in[l1] * MAX_FREQ
-                        + f0 - MIN_FREQ) * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                b0 = iv_alpha;
-                b1 = 0;
-                b2 = -iv_alpha;
-                a0 = 1.0 + iv_alpha;
-                a1 = -2.0 * iv_cos;
-                a2 = 1.0 - iv_alpha;
-                out = 1.0 / a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
-        else {
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in && (freq_in[l1] > 0)) 
-                    ? (freq_in[l1] * MAX_FREQ
-                        + f0 - MIN_FREQ) * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                q = q0  + reso_in[l1];
-                if (q < Q_MIN)
-                    q = Q_MIN;
-                if (q > Q_MAX)
-                    q = Q_MAX;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                b0 = iv_alpha;
-                b1 = 0;
-                b2 = -iv_alpha;
-                a0 = 1.0 + iv_alpha;
-                a1 = -2.0 * iv_cos;
-                a2 = 1.0 - iv_alpha;
-                inv_a0 = 1.0 / a0;
-                out = inv_a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    int conn;
+    if (count) {
+        conn = cvActiveConnections(pluginData->freq_in, pluginData->reso_in,
+                                   NULL, count);
+        Bandpass2CVKernels[conn](instance, count);
     }
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initBandpass2CV()
@@ -298,6 +209,99 @@ static void initBandpass2CV()
     Bandpass2CVDescriptor->extension_data =   NULL;
 }
 
+static LV2_Handle instantiateBandpass2Multi(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltMulti(descriptor, s_rate, Bandpass2MultiDescriptor, 0);
+}
+
+static VCF_SIMD void runBandpass2Multi(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltMulti((filtMulti *)instance, sample_count, RBJ_BANDPASS2);
+}
+
+static void initBandpass2Multi(int index)
+{
+    Bandpass2MultiDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    Bandpass2MultiDescriptor[index]->URI =              Bandpass2MultiURI[index];
+    Bandpass2MultiDescriptor[index]->activate =         activateFiltMulti;
+    Bandpass2MultiDescriptor[index]->cleanup =          cleanupFiltMulti;
+    Bandpass2MultiDescriptor[index]->connect_port =     connectPortFiltMulti;
+    Bandpass2MultiDescriptor[index]->deactivate =       NULL;
+    Bandpass2MultiDescriptor[index]->instantiate =      instantiateBandpass2Multi;
+    Bandpass2MultiDescriptor[index]->run =              runBandpass2Multi;
+    Bandpass2MultiDescriptor[index]->extension_data =   NULL;
+}
+
+static LV2_Handle instantiateBandpass2Voices(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltVoices(descriptor, s_rate,
+                                 Bandpass2VoicesDescriptor, 0);
+}
+
+static VCF_SIMD void runBandpass2Voices(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltVoices((filtVoices *)instance, sample_count, RBJ_BANDPASS2);
+}
+
+static void initBandpass2Voices(int index)
+{
+    Bandpass2VoicesDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    Bandpass2VoicesDescriptor[index]->URI =              Bandpass2VoicesURI[index];
+    Bandpass2VoicesDescriptor[index]->activate =         activateFiltVoices;
+    Bandpass2VoicesDescriptor[index]->cleanup =          cleanupFiltVoices;
+    Bandpass2VoicesDescriptor[index]->connect_port =     connectPortFiltVoices;
+    Bandpass2VoicesDescriptor[index]->deactivate =       NULL;
+    Bandpass2VoicesDescriptor[index]->instantiate =      instantiateBandpass2Voices;
+    Bandpass2VoicesDescriptor[index]->run =              runBandpass2Voices;
+    Bandpass2VoicesDescriptor[index]->extension_data =   NULL;
+}
+
+static inline void runBandpass2SVFConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltSVFConn((filtSVF *)instance, sample_count, RBJ_BANDPASS2, conn);
+}
+
+CV_KERNELS_NO_DBGAIN(Bandpass2SVFKernels, runBandpass2SVFConn)
+
+static LV2_Handle instantiateBandpass2SVF(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltSVF(s_rate, 0);
+}
+
+static void runBandpass2SVF(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltSVF((filtSVF *)instance, sample_count, Bandpass2SVFKernels);
+}
+
+static void initBandpass2SVF()
+{
+    Bandpass2SVFDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    Bandpass2SVFDescriptor->URI =              BANDPASS2SVF_URI;
+    Bandpass2SVFDescriptor->activate =         activateFiltSVF;
+    Bandpass2SVFDescriptor->cleanup =          cleanupFiltSVF;
+    Bandpass2SVFDescriptor->connect_port =     connectPortFiltSVF;
+    Bandpass2SVFDescriptor->deactivate =       NULL;
+    Bandpass2SVFDescriptor->instantiate =      instantiateBandpass2SVF;
+    Bandpass2SVFDescriptor->run =              runBandpass2SVF;
+    Bandpass2SVFDescriptor->extension_data =   NULL;
+}
+
 LV2_SYMBOL_EXPORT
 const LV2_Descriptor *lv2_descriptor(uint32_t index)
 {
@@ -310,6 +314,23 @@ const LV2_Descriptor *lv2_descriptor(uint32_t index)
             if (!Bandpass2CVDescriptor)
                 initBandpass2CV();
             return Bandpass2CVDescriptor;
+        case 2:
+        case 3:
+        case 4:
+        case 5:
+            if (!Bandpass2MultiDescriptor[index - 2])
+                initBandpass2Multi(index - 2);
+            return Bandpass2MultiDescriptor[index - 2];
+        case 6:
+        case 7:
+        case 8:
+            if (!Bandpass2VoicesDescriptor[index - 6])
+                initBandpass2Voices(index - 6);
+            return Bandpass2VoicesDescriptor[index - 6];
+        case 9:
+            if (!Bandpass2SVFDescriptor)
+                initBandpass2SVF();
+            return Bandpass2SVFDescriptor;
     }
     return NULL;
 }
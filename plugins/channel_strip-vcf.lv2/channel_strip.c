@@ -0,0 +1,61 @@
+/******************* Channel strip, Formulas by Robert Bristow-Johnson ********************/
+/*  Low shelf, peaking bands and high shelf in one pass, see
+    filter_strip.h
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <lv2.h>
+
+#include "vcf.h"
+#include "filter_strip.h"
+
+#define CHANNELSTRIP_URI "http://jwm-art.net/lv2/vcf/channel_strip";
+
+static LV2_Descriptor *ChannelStripDescriptor = NULL;
+
+static LV2_Handle instantiateChannelStrip(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltStrip(s_rate);
+}
+
+static VCF_SIMD void runChannelStrip(LV2_Handle instance, uint32_t sample_count)
+{
+    filtStrip *pluginData = (filtStrip *)instance;
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    if (count)
+        runFiltStrip(pluginData, count);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
+}
+
+static void initChannelStrip()
+{
+    ChannelStripDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    ChannelStripDescriptor->URI =              CHANNELSTRIP_URI;
+    ChannelStripDescriptor->activate =         activateFiltStrip;
+    ChannelStripDescriptor->cleanup =          cleanupFiltStrip;
+    ChannelStripDescriptor->connect_port =     connectPortFiltStrip;
+    ChannelStripDescriptor->deactivate =       NULL;
+    ChannelStripDescriptor->instantiate =      instantiateChannelStrip;
+    ChannelStripDescriptor->run =              runChannelStrip;
+    ChannelStripDescriptor->extension_data =   NULL;
+}
+
+LV2_SYMBOL_EXPORT
+const LV2_Descriptor *lv2_descriptor(uint32_t index)
+{
+    switch(index){
+        case 0:
+            if (!ChannelStripDescriptor)
+                initChannelStrip();
+            return ChannelStripDescriptor;
+    }
+    return NULL;
+}
@@ -0,0 +1,57 @@
+/******************* Crossover, Formula by Robert Bristow-Johnson ******************/
+/*  Linkwitz-Riley crossovers from the lowpass and highpass formulas, see
+    filter_crossover.h
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <lv2.h>
+
+#include "vcf.h"
+#include "filter_crossover.h"
+
+static LV2_Descriptor *CrossoverDescriptor[XOVER_DESCRIPTORS];
+
+static const char *CrossoverURI[XOVER_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/crossover_2way",
+    "http://jwm-art.net/lv2/vcf/crossover_3way",
+    "http://jwm-art.net/lv2/vcf/crossover_4way"
+};
+
+static LV2_Handle instantiateCrossover(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltCrossover(descriptor, s_rate, CrossoverDescriptor);
+}
+
+static VCF_SIMD void runCrossover(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltCrossover((filtCrossover *)instance, sample_count);
+}
+
+static void initCrossover(int index)
+{
+    CrossoverDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    CrossoverDescriptor[index]->URI =              CrossoverURI[index];
+    CrossoverDescriptor[index]->activate =         activateFiltCrossover;
+    CrossoverDescriptor[index]->cleanup =          cleanupFiltCrossover;
+    CrossoverDescriptor[index]->connect_port =     connectPortFiltCrossover;
+    CrossoverDescriptor[index]->deactivate =       NULL;
+    CrossoverDescriptor[index]->instantiate =      instantiateCrossover;
+    CrossoverDescriptor[index]->run =              runCrossover;
+    CrossoverDescriptor[index]->extension_data =   NULL;
+}
+
+LV2_SYMBOL_EXPORT
+const LV2_Descriptor *lv2_descriptor(uint32_t index)
+{
+    if (index >= XOVER_DESCRIPTORS)
+        return NULL;
+    if (!CrossoverDescriptor[index])
+        initCrossover(index);
+    return CrossoverDescriptor[index];
+}
@@ -0,0 +1,62 @@
+/******************* Graphic EQ, Formula by Robert Bristow-Johnson ********************/
+/*  Octave and third-octave peaking bands in one pass, see
+    filter_geq.h
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <lv2.h>
+
+#include "vcf.h"
+#include "filter_geq.h"
+
+static LV2_Descriptor *GraphicEQDescriptor[GEQ_DESCRIPTORS];
+
+static const char *GraphicEQURI[GEQ_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/graphic_eq_10",
+    "http://jwm-art.net/lv2/vcf/graphic_eq_31"
+};
+
+static LV2_Handle instantiateGraphicEQ(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltGEQ(descriptor, s_rate, GraphicEQDescriptor);
+}
+
+static VCF_SIMD void runGraphicEQ(LV2_Handle instance, uint32_t sample_count)
+{
+    filtGEQ *pluginData = (filtGEQ *)instance;
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    if (count)
+        runFiltGEQ(pluginData, count);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
+}
+
+static void initGraphicEQ(int index)
+{
+    GraphicEQDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    GraphicEQDescriptor[index]->URI =              GraphicEQURI[index];
+    GraphicEQDescriptor[index]->activate =         activateFiltGEQ;
+    GraphicEQDescriptor[index]->cleanup =          cleanupFiltGEQ;
+    GraphicEQDescriptor[index]->connect_port =     connectPortFiltGEQ;
+    GraphicEQDescriptor[index]->deactivate =       NULL;
+    GraphicEQDescriptor[index]->instantiate =      instantiateGraphicEQ;
+    GraphicEQDescriptor[index]->run =              runGraphicEQ;
+    GraphicEQDescriptor[index]->extension_data =   NULL;
+}
+
+LV2_SYMBOL_EXPORT
+const LV2_Descriptor *lv2_descriptor(uint32_t index)
+{
+    if (index >= GEQ_DESCRIPTORS)
+        return NULL;
+    if (!GraphicEQDescriptor[index])
+        initGraphicEQ(index);
+    return GraphicEQDescriptor[index];
+}
@@ -9,12 +9,35 @@
 
 #include "vcf.h"
 #include "filter_type3.h"
+#include "filter_multi.h"
+#include "filter_voices.h"
+#include "filter_svf.h"
+#include "filter_dynamic.h"
 
-#define HIGHSHELF_URI   "http://jwm-art.net/lv2/vcf/high_shelf";
-#define HIGHSHELFCV_URI "http://jwm-art.net/lv2/vcf/high_shelf_cv";
+#define HIGHSHELF_URI    "http://jwm-art.net/lv2/vcf/high_shelf";
+#define HIGHSHELFCV_URI  "http://jwm-art.net/lv2/vcf/high_shelf_cv";
+#define HIGHSHELFSVF_URI "http://jwm-art.net/lv2/vcf/high_shelf_svf";
+#define HIGHSHELFDYN_URI "http://jwm-art.net/lv2/vcf/high_shelf_dyn";
 
 static LV2_Descriptor *HighShelfDescriptor = NULL;
 static LV2_Descriptor *HighShelfCVDescriptor = NULL;
+static LV2_Descriptor *HighShelfSVFDescriptor = NULL;
+static LV2_Descriptor *HighShelfDynDescriptor = NULL;
+static LV2_Descriptor *HighShelfMultiDescriptor[MULTI_DESCRIPTORS];
+static LV2_Descriptor *HighShelfVoicesDescriptor[VOICES_DESCRIPTORS];
+
+static const char *HighShelfMultiURI[MULTI_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/high_shelf_x2",
+    "http://jwm-art.net/lv2/vcf/high_shelf_x8",
+    "http://jwm-art.net/lv2/vcf/high_shelf_x16",
+    "http://jwm-art.net/lv2/vcf/high_shelf_x64"
+};
+
+static const char *HighShelfVoicesURI[VOICES_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/high_shelf_voices8",
+    "http://jwm-art.net/lv2/vcf/high_shelf_voices16",
+    "http://jwm-art.net/lv2/vcf/high_shelf_voices32"
+};
 
 typedef filtType3    HighShelf;
 typedef filtType3_cv HighShelfCV;
@@ -36,6 +59,8 @@ static void connectPortHighShelf(
         case 4: plugin->freq_pitch = data;  break;
         case 5: plugin->reso_ofs = data;    break;
         case 6: plugin->dBgain_ofs = data;  break;
+        case 7: plugin->bypass.enabled = data; break;
+        case 8: plugin->params.control = data; break;
     }
 }
 
@@ -47,6 +72,10 @@ static LV2_Handle instantiateHighShelf(
 {
     HighShelf* plugin_data = (HighShelf*)malloc(sizeof(HighShelf));
     plugin_data->rate = s_rate;
+    plugin_data->controls.valid = 0;
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    paramEventsInit(&plugin_data->params, features);
     return (LV2_Handle)plugin_data;
 }
 
@@ -58,57 +87,14 @@ static void activateHighShelf(LV2_Handle instance)
       plugin_data->buf[l1] = 0;
 }
 
-static void runHighShelf(LV2_Handle instance, uint32_t sample_count)
+static VCF_SIMD void runHighShelf(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    float out;
-    double f, q, pi2_rate;
-    float A, iv_beta;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha;
-    double inv_a0, a0, a1, a2, b0, b1, b2;
     HighShelf *pluginData = (HighShelf *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    float dBgain = *(pluginData->dBgain_ofs);
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f = *(pluginData->freq_ofs) * freq_pitch;
-    if (f < MIN_FREQ)
-        f = MIN_FREQ;
-    if (f > MAX_FREQ)
-        f = MAX_FREQ;
-    q = *(pluginData->reso_ofs);
-    if (q < Q_MIN)
-        q = Q_MIN;
-    if (q > Q_MAX)
-        q = Q_MAX;
-    iv_sin = sin(pi2_rate * f);
-    iv_cos = cos(pi2_rate * f);
-    iv_alpha = iv_sin / (Q_SCALE * q);
-    A = exp(dBgain / 40.0 * log(10.0));
-    iv_beta = sqrt(A) / q;
-    b0 = A * (A + 1.0 + (A - 1.0) * iv_cos + iv_beta * iv_sin);
-    b1 = -2.0 * A * (A - 1.0 + (A + 1.0) * iv_cos);
-    b2 = A * (A + 1.0 + (A - 1.0) * iv_cos - iv_beta * iv_sin);
-    a0 = A + 1.0 - (A - 1.0) * iv_cos + iv_beta * iv_sin;
-    a1 = 2.0 * (A - 1.0 - (A + 1.0) * iv_cos);
-    a2 = A + 1.0 - (A - 1.0) * iv_cos - iv_beta * iv_sin;
-    inv_a0 = 1.0 / a0;
-    for (l1 = 0; l1 < sample_count; l1++) {
-        out = inv_a0 * (gain
-            * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                - a1 * buf[2] - a2 * buf[3]);
-        buf[1] = buf[0];
-        buf[0] = input[l1];
-        buf[3] = buf[2];
-        buf[2] = output[l1] = out;
-    }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    runFiltType3(pluginData, count, RBJ_HIGH_SHELF);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initHighShelf()
@@ -127,9 +113,19 @@ static void initHighShelf()
 
 static void cleanupHighShelfCV(LV2_Handle instance)
 {
+    HighShelfCV *plugin_data = (HighShelfCV *)instance;
+    coefTableRelease(plugin_data->table);
     free(instance);
 }
 
+static inline void runHighShelfCVConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltType3CV((HighShelfCV *)instance, sample_count, RBJ_HIGH_SHELF, conn);
+}
+
+CV_KERNELS(HighShelfCVKernels, runHighShelfCVConn)
+
 static void connectPortHighShelfCV(
     LV2_Handle instance, uint32_t port, void *data)
 {
@@ -145,6 +141,10 @@ static void connectPortHighShelfCV(
         case 7: plugin->reso_in = data;     break;
         case 8: plugin->dBgain_ofs = data;  break;
         case 9: plugin->dBgain_in = data;   break;
+        case 10: plugin->mod_rate = data;   break;
+        case 11: plugin->bypass.enabled = data; break;
+        default: modSourceConnect(&plugin->mod, port - 12, data);
+                 break;
     }
 }
 
@@ -156,6 +156,17 @@ static LV2_Handle instantiateHighShelfCV(
 {
     HighShelfCV* plugin_data = (HighShelfCV*)malloc(sizeof(HighShelfCV));
     plugin_data->rate = s_rate;
+    plugin_data->freq_in = NULL;
+    plugin_data->reso_in = NULL;
+    plugin_data->dBgain_in = NULL;
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    modSourceInit(&plugin_data->mod, s_rate, features);
+    plugin_data->table = coefTableAcquire(s_rate);
+    if (!plugin_data->table) {
+        free(plugin_data);
+        return NULL;
+    }
     return (LV2_Handle)plugin_data;
 }
 
@@ -165,144 +176,22 @@ static void activateHighShelfCV(LV2_Handle instance)
     int l1;
     for (l1 = 0; l1 < 4; l1++)
       plugin_data->buf[l1] = 0;
+    plugin_data->coefs_valid = 0;
 }
 
 static void runHighShelfCV(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    float out;
-    double f0, q0, f, q, pi2_rate;
-    float A, dBgain, iv_beta;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha;
-    double inv_a0, a0, a1, a2, b0, b1, b2;
     HighShelfCV *pluginData = (HighShelfCV *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_ofs = *(pluginData->freq_ofs);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    float reso_ofs = *(pluginData->reso_ofs);
-    float *freq_in = pluginData->freq_in;
-    float *reso_in = pluginData->reso_in;
-    float dBgain_ofs = *(pluginData->dBgain_ofs);
-    float *dBgain_in = pluginData->dBgain_in;
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f0 = freq_ofs;
-    q0 = reso_ofs;
-    if (!(freq_in || reso_in || dBgain_in)) {
-        f = f0 * freq_pitch;
-        if (f < MIN_FREQ)
-            f = MIN_FREQ;
-        if (f > MAX_FREQ)
-            f = MAX_FREQ;
-        q = q0;
-        if (q < Q_MIN)
-            q = Q_MIN;
-        if (q > Q_MAX)
-            q = Q_MAX;
-        dBgain = dBgain_ofs;
-        iv_sin = sin(pi2_rate * f);
-        iv_cos = cos(pi2_rate * f);
-        iv_alpha = iv_sin/(Q_SCALE * q);
-        A = exp(dBgain/40.0 * log(10.0));
-        iv_beta = sqrt(A) / q;
-        b0 = A * (A + 1.0 + (A - 1.0) * iv_cos + iv_beta * iv_sin);
-        b1 = -2.0 * A * (A - 1.0 + (A + 1.0) * iv_cos);
-        b2 = A * (A + 1.0 + (A - 1.0) * iv_cos - iv_beta * iv_sin);
-        a0 = A + 1.0 - (A - 1.0) * iv_cos + iv_beta * iv_sin;
-        a1 = 2.0 * (A - 1.0 - (A + 1.0) * iv_cos);
-        a2 = A + 1.0 - (A - 1.0) * iv_cos - iv_beta * iv_sin;
-        inv_a0 = 1.0 / a0;
-        for (l1 = 0; l1 < sample_count; l1++) {
-            out = inv_a0 * (gain
-                * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                    - a1 * buf[2] - a2 * buf[3]);
-            buf[1] = buf[0];
-            buf[0] = input[l1];
-            buf[3] = buf[2];
-            buf[2] = output[l1] = out;
-        }
-    }
-    else {
-        if (!reso_in || dBgain_in) {
-            q = q0;
-            if (q < Q_MIN)
-                q = Q_MIN;
-            if (q > Q_MAX)
-                q = Q_MAX;
-            dBgain = dBgain_ofs;
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in[l1] > 0)
-                    ? (freq_in[l1] * MAX_FREQ
-                        + f0 - MIN_FREQ) * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                A = exp(dBgain/40.0 * log(10.0));
-                iv_beta = sqrt(A) / q;
-                b0 = A * (A + 1.0 + (A - 1.0) * iv_cos + iv_beta * iv_sin);
-                b1 = -2.0 * A * (A - 1.0 + (A + 1.0) * iv_cos);
-                b2 = A * (A + 1.0 + (A - 1.0) * iv_cos - iv_beta * iv_sin);
-                a0 = A + 1.0 - (A - 1.0) * iv_cos + iv_beta * iv_sin;
-                a1 = 2.0 * (A - 1.0 - (A + 1.0) * iv_cos);
-                a2 = A + 1.0 - (A - 1.0) * iv_cos - iv_beta * iv_sin;
-                out = 1.0 / a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
-        else {
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in && (freq_in[l1] > 0))
-                    ? (freq_in[l1] * MAX_FREQ + f0 - MIN_FREQ)
-                        * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                q = q0  + reso_in[l1];
-                if (q < Q_MIN)
-                    q = Q_MIN;
-                if (q > Q_MAX)
-                    q = Q_MAX;
-                dBgain = (dBgain_in) ? dBgain_ofs + DBGAIN_SCALE * dBgain_in[l1] : dBgain_ofs;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                A = exp(dBgain/40.0 * log(10.0));
-                iv_beta = sqrt(A) / q;
-                b0 = A * (A + 1.0 + (A - 1.0) * iv_cos + iv_beta * iv_sin);
-                b1 = -2.0 * A * (A - 1.0 + (A + 1.0) * iv_cos);
-                b2 = A * (A + 1.0 + (A - 1.0) * iv_cos - iv_beta * iv_sin);
-                a0 = A + 1.0 - (A - 1.0) * iv_cos + iv_beta * iv_sin;
-                a1 = 2.0 * (A - 1.0 - (A + 1.0) * iv_cos);
-                a2 = A + 1.0 - (A - 1.0) * iv_cos - iv_beta * iv_sin;
-                inv_a0 = 1.0 / a0;
-                out = inv_a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    int conn;
+    if (count) {
+        conn = cvActiveConnections(pluginData->freq_in, pluginData->reso_in,
+                                   pluginData->dBgain_in, count);
+        HighShelfCVKernels[conn](instance, count);
     }
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initHighShelfCV()
@@ -319,6 +208,133 @@ static void initHighShelfCV()
     HighShelfCVDescriptor->extension_data =   NULL;
 }
 
+static LV2_Handle instantiateHighShelfMulti(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltMulti(descriptor, s_rate, HighShelfMultiDescriptor, 1);
+}
+
+static VCF_SIMD void runHighShelfMulti(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltMulti((filtMulti *)instance, sample_count, RBJ_HIGH_SHELF);
+}
+
+static void initHighShelfMulti(int index)
+{
+    HighShelfMultiDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    HighShelfMultiDescriptor[index]->URI =              HighShelfMultiURI[index];
+    HighShelfMultiDescriptor[index]->activate =         activateFiltMulti;
+    HighShelfMultiDescriptor[index]->cleanup =          cleanupFiltMulti;
+    HighShelfMultiDescriptor[index]->connect_port =     connectPortFiltMulti;
+    HighShelfMultiDescriptor[index]->deactivate =       NULL;
+    HighShelfMultiDescriptor[index]->instantiate =      instantiateHighShelfMulti;
+    HighShelfMultiDescriptor[index]->run =              runHighShelfMulti;
+    HighShelfMultiDescriptor[index]->extension_data =   NULL;
+}
+
+static LV2_Handle instantiateHighShelfVoices(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltVoices(descriptor, s_rate,
+                                 HighShelfVoicesDescriptor, 1);
+}
+
+static VCF_SIMD void runHighShelfVoices(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltVoices((filtVoices *)instance, sample_count, RBJ_HIGH_SHELF);
+}
+
+static void initHighShelfVoices(int index)
+{
+    HighShelfVoicesDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    HighShelfVoicesDescriptor[index]->URI =              HighShelfVoicesURI[index];
+    HighShelfVoicesDescriptor[index]->activate =         activateFiltVoices;
+    HighShelfVoicesDescriptor[index]->cleanup =          cleanupFiltVoices;
+    HighShelfVoicesDescriptor[index]->connect_port =     connectPortFiltVoices;
+    HighShelfVoicesDescriptor[index]->deactivate =       NULL;
+    HighShelfVoicesDescriptor[index]->instantiate =      instantiateHighShelfVoices;
+    HighShelfVoicesDescriptor[index]->run =              runHighShelfVoices;
+    HighShelfVoicesDescriptor[index]->extension_data =   NULL;
+}
+
+static inline void runHighShelfSVFConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltSVFConn((filtSVF *)instance, sample_count, RBJ_HIGH_SHELF, conn);
+}
+
+CV_KERNELS(HighShelfSVFKernels, runHighShelfSVFConn)
+
+static LV2_Handle instantiateHighShelfSVF(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltSVF(s_rate, 1);
+}
+
+static void runHighShelfSVF(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltSVF((filtSVF *)instance, sample_count, HighShelfSVFKernels);
+}
+
+static void initHighShelfSVF()
+{
+    HighShelfSVFDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    HighShelfSVFDescriptor->URI =              HIGHSHELFSVF_URI;
+    HighShelfSVFDescriptor->activate =         activateFiltSVF;
+    HighShelfSVFDescriptor->cleanup =          cleanupFiltSVF;
+    HighShelfSVFDescriptor->connect_port =     connectPortFiltSVF;
+    HighShelfSVFDescriptor->deactivate =       NULL;
+    HighShelfSVFDescriptor->instantiate =      instantiateHighShelfSVF;
+    HighShelfSVFDescriptor->run =              runHighShelfSVF;
+    HighShelfSVFDescriptor->extension_data =   NULL;
+}
+
+static LV2_Handle instantiateHighShelfDyn(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltDynamic(s_rate);
+}
+
+static VCF_SIMD void runHighShelfDyn(LV2_Handle instance, uint32_t sample_count)
+{
+    filtDynamic *pluginData = (filtDynamic *)instance;
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    if (count)
+        runFiltDynamic(pluginData, count, RBJ_HIGH_SHELF);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
+}
+
+static void initHighShelfDyn()
+{
+    HighShelfDynDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    HighShelfDynDescriptor->URI =              HIGHSHELFDYN_URI;
+    HighShelfDynDescriptor->activate =         activateFiltDynamic;
+    HighShelfDynDescriptor->cleanup =          cleanupFiltDynamic;
+    HighShelfDynDescriptor->connect_port =     connectPortFiltDynamic;
+    HighShelfDynDescriptor->deactivate =       NULL;
+    HighShelfDynDescriptor->instantiate =      instantiateHighShelfDyn;
+    HighShelfDynDescriptor->run =              runHighShelfDyn;
+    HighShelfDynDescriptor->extension_data =   NULL;
+}
+
 LV2_SYMBOL_EXPORT
 const LV2_Descriptor *lv2_descriptor(uint32_t index)
 {
@@ -331,6 +347,27 @@ const LV2_Descriptor *lv2_descriptor(uint32_t index)
             if (!HighShelfCVDescriptor)
                 initHighShelfCV();
             return HighShelfCVDescriptor;
+        case 2:
+        case 3:
+        case 4:
+        case 5:
+            if (!HighShelfMultiDescriptor[index - 2])
+                initHighShelfMulti(index - 2);
+            return HighShelfMultiDescriptor[index - 2];
+        case 6:
+        case 7:
+        case 8:
+            if (!HighShelfVoicesDescriptor[index - 6])
+                initHighShelfVoices(index - 6);
+            return HighShelfVoicesDescriptor[index - 6];
+        case 9:
+            if (!HighShelfSVFDescriptor)
+                initHighShelfSVF();
+            return HighShelfSVFDescriptor;
+        case 10:
+            if (!HighShelfDynDescriptor)
+                initHighShelfDyn();
+            return HighShelfDynDescriptor;
     }
     return NULL;
 }
@@ -9,12 +9,35 @@
 
 #include "vcf.h"
 #include "filter_type3.h"
+#include "filter_multi.h"
+#include "filter_voices.h"
+#include "filter_svf.h"
+#include "filter_dynamic.h"
 
-#define LOWSHELF_URI   "http://jwm-art.net/lv2/vcf/low_shelf";
-#define LOWSHELFCV_URI "http://jwm-art.net/lv2/vcf/low_shelf_cv";
+#define LOWSHELF_URI    "http://jwm-art.net/lv2/vcf/low_shelf";
+#define LOWSHELFCV_URI  "http://jwm-art.net/lv2/vcf/low_shelf_cv";
+#define LOWSHELFSVF_URI "http://jwm-art.net/lv2/vcf/low_shelf_svf";
+#define LOWSHELFDYN_URI "http://jwm-art.net/lv2/vcf/low_shelf_dyn";
 
 static LV2_Descriptor *LowShelfDescriptor = NULL;
 static LV2_Descriptor *LowShelfCVDescriptor = NULL;
+static LV2_Descriptor *LowShelfSVFDescriptor = NULL;
+static LV2_Descriptor *LowShelfDynDescriptor = NULL;
+static LV2_Descriptor *LowShelfMultiDescriptor[MULTI_DESCRIPTORS];
+static LV2_Descriptor *LowShelfVoicesDescriptor[VOICES_DESCRIPTORS];
+
+static const char *LowShelfMultiURI[MULTI_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/low_shelf_x2",
+    "http://jwm-art.net/lv2/vcf/low_shelf_x8",
+    "http://jwm-art.net/lv2/vcf/low_shelf_x16",
+    "http://jwm-art.net/lv2/vcf/low_shelf_x64"
+};
+
+static const char *LowShelfVoicesURI[VOICES_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/low_shelf_voices8",
+    "http://jwm-art.net/lv2/vcf/low_shelf_voices16",
+    "http://jwm-art.net/lv2/vcf/low_shelf_voices32"
+};
 
 typedef filtType3    LowShelf;
 typedef filtType3_cv LowShelfCV;
@@ -36,6 +59,8 @@ static void connectPortLowShelf(
         case 4: plugin->freq_pitch = data;  break;
         case 5: plugin->reso_ofs = data;    break;
         case 6: plugin->dBgain_ofs = data;  break;
+        case 7: plugin->bypass.enabled = data; break;
+        case 8: plugin->params.control = data; break;
     }
 }
 
@@ -47,6 +72,10 @@ static LV2_Handle instantiateLowShelf(
 {
     LowShelf* plugin_data = (LowShelf*)malloc(sizeof(LowShelf));
     plugin_data->rate = s_rate;
+    plugin_data->controls.valid = 0;
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    paramEventsInit(&plugin_data->params, features);
     return (LV2_Handle)plugin_data;
 }
 
@@ -58,58 +87,14 @@ static void activateLowShelf(LV2_Handle instance)
       plugin_data->buf[l1] = 0;
 }
 
-static void runLowShelf(LV2_Handle instance, uint32_t sample_count)
+static VCF_SIMD void runLowShelf(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    float out;
-    double f, q, pi2_rate;
-    float A, dBgain, iv_beta;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha;
-    double inv_a0, a0, a1, a2, b0, b1, b2;
     LowShelf *pluginData = (LowShelf *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    float dBgain_ofs = *(pluginData->dBgain_ofs);
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f = *(pluginData->freq_ofs) * freq_pitch;
-    if (f < MIN_FREQ)
-        f = MIN_FREQ;
-    if (f > MAX_FREQ)
-        f = MAX_FREQ;
-    q = *(pluginData->reso_ofs);
-    if (q < Q_MIN)
-        q = Q_MIN;
-    if (q > Q_MAX)
-        q = Q_MAX;
-    dBgain = dBgain_ofs;
-    iv_sin = sin(pi2_rate * f);
-    iv_cos = cos(pi2_rate * f);
-    iv_alpha = iv_sin / (Q_SCALE * q);
-    A = exp(dBgain / 40.0 * log(10.0));
-    iv_beta = sqrt(A) / q;
-    b0 = A * (A + 1.0 - (A - 1.0) * iv_cos + iv_beta * iv_sin);
-    b1 = 2.0 * A * (A - 1.0 - (A + 1.0) * iv_cos);
-    b2 = A * (A + 1.0 - (A - 1.0) * iv_cos - iv_beta * iv_sin);
-    a0 = A + 1.0 + (A - 1.0) * iv_cos + iv_beta * iv_sin;
-    a1 = -2.0 * (A - 1.0 + (A + 1.0) * iv_cos);
-    a2 = A + 1.0 + (A - 1.0) * iv_cos - iv_beta * iv_sin;
-    inv_a0 = 1.0 / a0;
-    for (l1 = 0; l1 < sample_count; l1++) {
-        out = inv_a0 * (gain
-            * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                - a1 * buf[2] - a2 * buf[3]);
-        buf[1] = buf[0];
-        buf[0] = input[l1];
-        buf[3] = buf[2];
-        buf[2] = output[l1] = out;
-    }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    runFiltType3(pluginData, count, RBJ_LOW_SHELF);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initLowShelf()
@@ -128,9 +113,19 @@ static void initLowShelf()
 
 static void cleanupLowShelfCV(LV2_Handle instance)
 {
+    LowShelfCV *plugin_data = (LowShelfCV *)instance;
+    coefTableRelease(plugin_data->table);
     free(instance);
 }
 
+static inline void runLowShelfCVConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltType3CV((LowShelfCV *)instance, sample_count, RBJ_LOW_SHELF, conn);
+}
+
+CV_KERNELS(LowShelfCVKernels, runLowShelfCVConn)
+
 static void connectPortLowShelfCV(
     LV2_Handle instance, uint32_t port, void *data)
 {
@@ -146,6 +141,10 @@ static void connectPortLowShelfCV(
         case 7: plugin->reso_in = data;     break;
         case 8: plugin->dBgain_ofs = data;  break;
         case 9: plugin->dBgain_in = data;   break;
+        case 10: plugin->mod_rate = data;   break;
+        case 11: plugin->bypass.enabled = data; break;
+        default: modSourceConnect(&plugin->mod, port - 12, data);
+                 break;
     }
 }
 
@@ -157,6 +156,17 @@ static LV2_Handle instantiateLowShelfCV(
 {
     LowShelfCV* plugin_data = (LowShelfCV*)malloc(sizeof(LowShelfCV));
     plugin_data->rate = s_rate;
+    plugin_data->freq_in = NULL;
+    plugin_data->reso_in = NULL;
+    plugin_data->dBgain_in = NULL;
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    modSourceInit(&plugin_data->mod, s_rate, features);
+    plugin_data->table = coefTableAcquire(s_rate);
+    if (!plugin_data->table) {
+        free(plugin_data);
+        return NULL;
+    }
     return (LV2_Handle)plugin_data;
 }
 
@@ -166,144 +176,22 @@ static void activateLowShelfCV(LV2_Handle instance)
     int l1;
     for (l1 = 0; l1 < 4; l1++)
       plugin_data->buf[l1] = 0;
+    plugin_data->coefs_valid = 0;
 }
 
 static void runLowShelfCV(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    float out;
-    double f0, q0, f, q, pi2_rate;
-    float A, dBgain, iv_beta;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha;
-    double inv_a0, a0, a1, a2, b0, b1, b2;
     LowShelfCV *pluginData = (LowShelfCV *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_ofs = *(pluginData->freq_ofs);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    float reso_ofs = *(pluginData->reso_ofs);
-    float *freq_in = pluginData->freq_in;
-    float *reso_in = pluginData->reso_in;
-    float dBgain_ofs = *(pluginData->dBgain_ofs);
-    float *dBgain_in = pluginData->dBgain_in;
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f0 = freq_ofs;
-    q0 = reso_ofs;
-    if (!(freq_in || reso_in || dBgain_in)) {
-        f = f0 * freq_pitch;
-        if (f < MIN_FREQ)
-            f = MIN_FREQ;
-        if (f > MAX_FREQ)
-            f = MAX_FREQ;
-        q = q0;
-        if (q < Q_MIN)
-            q = Q_MIN;
-        if (q > Q_MAX)
-            q = Q_MAX;
-        dBgain = dBgain_ofs;
-        iv_sin = sin(pi2_rate * f);
-        iv_cos = cos(pi2_rate * f);
-        iv_alpha = iv_sin/(Q_SCALE * q);
-        A = exp(dBgain/40.0 * log(10.0));
-        iv_beta = sqrt(A) / q;
-        b0 = A * (A + 1.0 - (A - 1.0) * iv_cos + iv_beta * iv_sin);
-        b1 = 2.0 * A * (A - 1.0 - (A + 1.0) * iv_cos);
-        b2 = A * (A + 1.0 - (A - 1.0) * iv_cos - iv_beta * iv_sin);
-        a0 = A + 1.0 + (A - 1.0) * iv_cos + iv_beta * iv_sin;
-        a1 = -2.0 * (A - 1.0 + (A + 1.0) * iv_cos);
-        a2 = A + 1.0 + (A - 1.0) * iv_cos - iv_beta * iv_sin;
-        inv_a0 = 1.0 / a0;
-        for (l1 = 0; l1 < sample_count; l1++) {
-            out = inv_a0 * (gain
-                * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                    - a1 * buf[2] - a2 * buf[3]);
-            buf[1] = buf[0];
-            buf[0] = input[l1];
-            buf[3] = buf[2];
-            buf[2] = output[l1] = out;
-        }
-    }
-    else {
-        if (!reso_in || dBgain_in) {
-            q = q0;
-            if (q < Q_MIN)
-                q = Q_MIN;
-            if (q > Q_MAX)
-                q = Q_MAX;
-            dBgain = dBgain_ofs;
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in[l1] > 0)
-                    ? (freq_in[l1] * MAX_FREQ
-                        + f0 - MIN_FREQ) * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                A = exp(dBgain/40.0 * log(10.0));
-                iv_beta = sqrt(A) / q;
-                b0 = A * (A + 1.0 - (A - 1.0) * iv_cos + iv_beta * iv_sin);
-                b1 = 2.0 * A * (A - 1.0 - (A + 1.0) * iv_cos);
-                b2 = A * (A + 1.0 - (A - 1.0) * iv_cos - iv_beta * iv_sin);
-                a0 = A + 1.0 + (A - 1.0) * iv_cos + iv_beta * iv_sin;
-                a1 = -2.0 * (A - 1.0 + (A + 1.0) * iv_cos);
-                a2 = A + 1.0 + (A - 1.0) * iv_cos - iv_beta * iv_sin;
-                out = 1.0 / a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
-        else {
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in && (freq_in[l1] > 0))
-                    ? (freq_in[l1] * MAX_FREQ + f0 - MIN_FREQ)
-                        * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                q = q0  + reso_in[l1];
-                if (q < Q_MIN)
-                    q = Q_MIN;
-                if (q > Q_MAX)
-                    q = Q_MAX;
-                dBgain = (dBgain_in) ? dBgain_ofs + DBGAIN_SCALE * dBgain_in[l1] : dBgain_ofs;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                A = exp(dBgain/40.0 * log(10.0));
-                iv_beta = sqrt(A) / q;
-                b0 = A * (A + 1.0 - (A - 1.0) * iv_cos + iv_beta * iv_sin);
-                b1 = 2.0 * A * (A - 1.0 - (A + 1.0) * iv_cos);
-                b2 = A * (A + 1.0 - (A - 1.0) * iv_cos - iv_beta * iv_sin);
-                a0 = A + 1.0 + (A - 1.0) * iv_cos + iv_beta * iv_sin;
-                a1 = -2.0 * (A - 1.0 + (A + 1.0) * iv_cos);
-                a2 = A + 1.0 + (A - 1.0) * iv_cos - iv_beta * iv_sin;
-                inv_a0 = 1.0 / a0;
-                out = inv_a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    int conn;
+    if (count) {
+        conn = cvActiveConnections(pluginData->freq_in, pluginData->reso_in,
+                                   pluginData->dBgain_in, count);
+        LowShelfCVKernels[conn](instance, count);
     }
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initLowShelfCV()
@@ -320,6 +208,133 @@ static void initLowShelfCV()
     LowShelfCVDescriptor->extension_data =   NULL;
 }
 
+static LV2_Handle instantiateLowShelfMulti(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltMulti(descriptor, s_rate, LowShelfMultiDescriptor, 1);
+}
+
+static VCF_SIMD void runLowShelfMulti(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltMulti((filtMulti *)instance, sample_count, RBJ_LOW_SHELF);
+}
+
+static void initLowShelfMulti(int index)
+{
+    LowShelfMultiDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    LowShelfMultiDescriptor[index]->URI =              LowShelfMultiURI[index];
+    LowShelfMultiDescriptor[index]->activate =         activateFiltMulti;
+    LowShelfMultiDescriptor[index]->cleanup =          cleanupFiltMulti;
+    LowShelfMultiDescriptor[index]->connect_port =     connectPortFiltMulti;
+    LowShelfMultiDescriptor[index]->deactivate =       NULL;
+    LowShelfMultiDescriptor[index]->instantiate =      instantiateLowShelfMulti;
+    LowShelfMultiDescriptor[index]->run =              runLowShelfMulti;
+    LowShelfMultiDescriptor[index]->extension_data =   NULL;
+}
+
+static LV2_Handle instantiateLowShelfVoices(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltVoices(descriptor, s_rate,
+                                 LowShelfVoicesDescriptor, 1);
+}
+
+static VCF_SIMD void runLowShelfVoices(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltVoices((filtVoices *)instance, sample_count, RBJ_LOW_SHELF);
+}
+
+static void initLowShelfVoices(int index)
+{
+    LowShelfVoicesDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    LowShelfVoicesDescriptor[index]->URI =              LowShelfVoicesURI[index];
+    LowShelfVoicesDescriptor[index]->activate =         activateFiltVoices;
+    LowShelfVoicesDescriptor[index]->cleanup =          cleanupFiltVoices;
+    LowShelfVoicesDescriptor[index]->connect_port =     connectPortFiltVoices;
+    LowShelfVoicesDescriptor[index]->deactivate =       NULL;
+    LowShelfVoicesDescriptor[index]->instantiate =      instantiateLowShelfVoices;
+    LowShelfVoicesDescriptor[index]->run =              runLowShelfVoices;
+    LowShelfVoicesDescriptor[index]->extension_data =   NULL;
+}
+
+static inline void runLowShelfSVFConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltSVFConn((filtSVF *)instance, sample_count, RBJ_LOW_SHELF, conn);
+}
+
+CV_KERNELS(LowShelfSVFKernels, runLowShelfSVFConn)
+
+static LV2_Handle instantiateLowShelfSVF(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltSVF(s_rate, 1);
+}
+
+static void runLowShelfSVF(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltSVF((filtSVF *)instance, sample_count, LowShelfSVFKernels);
+}
+
+static void initLowShelfSVF()
+{
+    LowShelfSVFDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    LowShelfSVFDescriptor->URI =              LOWSHELFSVF_URI;
+    LowShelfSVFDescriptor->activate =         activateFiltSVF;
+    LowShelfSVFDescriptor->cleanup =          cleanupFiltSVF;
+    LowShelfSVFDescriptor->connect_port =     connectPortFiltSVF;
+    LowShelfSVFDescriptor->deactivate =       NULL;
+    LowShelfSVFDescriptor->instantiate =      instantiateLowShelfSVF;
+    LowShelfSVFDescriptor->run =              runLowShelfSVF;
+    LowShelfSVFDescriptor->extension_data =   NULL;
+}
+
+static LV2_Handle instantiateLowShelfDyn(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltDynamic(s_rate);
+}
+
+static VCF_SIMD void runLowShelfDyn(LV2_Handle instance, uint32_t sample_count)
+{
+    filtDynamic *pluginData = (filtDynamic *)instance;
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    if (count)
+        runFiltDynamic(pluginData, count, RBJ_LOW_SHELF);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
+}
+
+static void initLowShelfDyn()
+{
+    LowShelfDynDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    LowShelfDynDescriptor->URI =              LOWSHELFDYN_URI;
+    LowShelfDynDescriptor->activate =         activateFiltDynamic;
+    LowShelfDynDescriptor->cleanup =          cleanupFiltDynamic;
+    LowShelfDynDescriptor->connect_port =     connectPortFiltDynamic;
+    LowShelfDynDescriptor->deactivate =       NULL;
+    LowShelfDynDescriptor->instantiate =      instantiateLowShelfDyn;
+    LowShelfDynDescriptor->run =              runLowShelfDyn;
+    LowShelfDynDescriptor->extension_data =   NULL;
+}
+
 LV2_SYMBOL_EXPORT
 const LV2_Descriptor *lv2_descriptor(uint32_t index)
 {
@@ -332,6 +347,27 @@ const LV2_Descriptor *lv2_descriptor(uint32_t index)
             if (!LowShelfCVDescriptor)
                 initLowShelfCV();
             return LowShelfCVDescriptor;
+        case 2:
+        case 3:
+        case 4:
+        case 5:
+            if (!LowShelfMultiDescriptor[index - 2])
+                initLowShelfMulti(index - 2);
+            return LowShelfMultiDescriptor[index - 2];
+        case 6:
+        case 7:
+        case 8:
+            if (!LowShelfVoicesDescriptor[index - 6])
+                initLowShelfVoices(index - 6);
+            return LowShelfVoicesDescriptor[index - 6];
+        case 9:
+            if (!LowShelfSVFDescriptor)
+                initLowShelfSVF();
+            return LowShelfSVFDescriptor;
+        case 10:
+            if (!LowShelfDynDescriptor)
+                initLowShelfDyn();
+            return LowShelfDynDescriptor;
     }
     return NULL;
 }
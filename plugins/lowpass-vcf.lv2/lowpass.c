@@ -9,12 +9,32 @@
 
 #include "vcf.h"
 #include "filter_type2.h"
+#include "filter_multi.h"
+#include "filter_voices.h"
+#include "filter_svf.h"
 
-#define LOWPASS_URI   "http://jwm-art.net/lv2/vcf/lowpass";
-#define LOWPASSCV_URI "http://jwm-art.net/lv2/vcf/lowpass_cv";
+#define LOWPASS_URI    "http://jwm-art.net/lv2/vcf/lowpass";
+#define LOWPASSCV_URI  "http://jwm-art.net/lv2/vcf/lowpass_cv";
+#define LOWPASSSVF_URI "http://jwm-art.net/lv2/vcf/lowpass_svf";
 
 static LV2_Descriptor *LowpassDescriptor = NULL;
 static LV2_Descriptor *LowpassCVDescriptor = NULL;
+static LV2_Descriptor *LowpassSVFDescriptor = NULL;
+static LV2_Descriptor *LowpassMultiDescriptor[MULTI_DESCRIPTORS];
+static LV2_Descriptor *LowpassVoicesDescriptor[VOICES_DESCRIPTORS];
+
+static const char *LowpassMultiURI[MULTI_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/lowpass_x2",
+    "http://jwm-art.net/lv2/vcf/lowpass_x8",
+    "http://jwm-art.net/lv2/vcf/lowpass_x16",
+    "http://jwm-art.net/lv2/vcf/lowpass_x64"
+};
+
+static const char *LowpassVoicesURI[VOICES_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/lowpass_voices8",
+    "http://jwm-art.net/lv2/vcf/lowpass_voices16",
+    "http://jwm-art.net/lv2/vcf/lowpass_voices32"
+};
 
 typedef filtType2    Lowpass;
 typedef filtType2_cv LowpassCV;
@@ -35,6 +55,10 @@ static void connectPortLowpass(
         case 3: plugin->freq_ofs = data;    break;
         case 4: plugin->freq_pitch = data;  break;
         case 5: plugin->reso_ofs = data;    break;
+        case 6: plugin->sections = data;    break;
+        case 7: plugin->response = data;    break;
+        case 8: plugin->bypass.enabled = data; break;
+        case 9: plugin->params.control = data; break;
     }
 }
 
@@ -46,6 +70,13 @@ static LV2_Handle instantiateLowpass(
 {
     Lowpass* plugin_data = (Lowpass*)malloc(sizeof(Lowpass));
     plugin_data->rate = s_rate;
+    plugin_data->controls.valid = 0;
+    plugin_data->sections = NULL;
+    plugin_data->response = NULL;
+    sosInit(&plugin_data->sos);
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    paramEventsInit(&plugin_data->params, features);
     return (LV2_Handle)plugin_data;
 }
 
@@ -53,57 +84,18 @@ static void activateLowpass(LV2_Handle instance)
 {
     Lowpass *plugin_data = (Lowpass *)instance;
     int l1;
-    for (l1 = 0; l1 < 4; l1++)
+    for (l1 = 0; l1 < 4 * SOS_MAX_SECTIONS; l1++)
       plugin_data->buf[l1] = 0;
 }
 
-static void runLowpass(LV2_Handle instance, uint32_t sample_count)
+static VCF_SIMD void runLowpass(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    float out;
-    double f, q, pi2_rate;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha;
-    double inv_a0, a0, a1, a2, b0, b1, b2;
     Lowpass *pluginData = (Lowpass *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f = *(pluginData->freq_ofs) * freq_pitch;
-    if (f < MIN_FREQ)
-        f = MIN_FREQ;
-    if (f > MAX_FREQ)
-        f = MAX_FREQ;
-    q = *(pluginData->reso_ofs);
-    if (q < Q_MIN)
-        q = Q_MIN;
-    if (q > Q_MAX)
-        q = Q_MAX;
-    iv_sin = sin(pi2_rate * f);
-    iv_cos = cos(pi2_rate * f);
-    iv_alpha = iv_sin/(Q_SCALE * q);
-    b0 = (1.0 - iv_cos) / 2.0;
-    b1 = 1.0 - iv_cos;
-    b2 = b0;
-    a0 = 1.0 + iv_alpha;
-    a1 = -2.0 * iv_cos;
-    a2 = 1.0 - iv_alpha;
-    inv_a0 = 1.0 / a0;
-    for (l1 = 0; l1 < sample_count; l1++) {
-        out = inv_a0 * (gain
-            * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                - a1 * buf[2] - a2 * buf[3]);
-        buf[1] = buf[0];
-        buf[0] = input[l1];
-        buf[3] = buf[2];
-        buf[2] = output[l1] = out;
-    }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    runFiltType2(pluginData, count, RBJ_LOWPASS);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initLowpass()
@@ -122,9 +114,19 @@ static void initLowpass()
 
 static void cleanupLowpassCV(LV2_Handle instance)
 {
+    LowpassCV *plugin_data = (LowpassCV *)instance;
+    coefTableRelease(plugin_data->table);
     free(instance);
 }
 
+static inline void runLowpassCVConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltType2CV((LowpassCV *)instance, sample_count, RBJ_LOWPASS, conn);
+}
+
+CV_KERNELS_NO_DBGAIN(LowpassCVKernels, runLowpassCVConn)
+
 static void connectPortLowpassCV(
     LV2_Handle instance, uint32_t port, void *data)
 {
@@ -138,6 +140,12 @@ static void connectPortLowpassCV(
         case 5: plugin->freq_in = data;     break;
         case 6: plugin->reso_ofs = data;    break;
         case 7: plugin->reso_in = data;     break;
+        case 8: plugin->mod_rate = data;    break;
+        case 9: plugin->sections = data;    break;
+        case 10: plugin->response = data;   break;
+        case 11: plugin->bypass.enabled = data; break;
+        default: modSourceConnect(&plugin->mod, port - 12, data);
+                 break;
     }
 }
 
@@ -149,6 +157,19 @@ static LV2_Handle instantiateLowpassCV(
 {
     LowpassCV* plugin_data = (LowpassCV*)malloc(sizeof(LowpassCV));
     plugin_data->rate = s_rate;
+    plugin_data->freq_in = NULL;
+    plugin_data->reso_in = NULL;
+    plugin_data->sections = NULL;
+    plugin_data->response = NULL;
+    sosInit(&plugin_data->sos);
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    modSourceInit(&plugin_data->mod, s_rate, features);
+    plugin_data->table = coefTableAcquire(s_rate);
+    if (!plugin_data->table) {
+        free(plugin_data);
+        return NULL;
+    }
     return (LV2_Handle)plugin_data;
 }
 
@@ -156,134 +177,24 @@ static void activateLowpassCV(LV2_Handle instance)
 {
     LowpassCV *plugin_data = (LowpassCV *)instance;
     int l1;
-    for (l1 = 0; l1 < 4; l1++)
+    for (l1 = 0; l1 < 4 * SOS_MAX_SECTIONS; l1++)
       plugin_data->buf[l1] = 0;
+    plugin_data->coefs_valid = 0;
 }
 
 static void runLowpassCV(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    float out;
-    double f0, q0, f, q, pi2_rate;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha;
-    double inv_a0, a0, a1, a2, b0, b1, b2;
     LowpassCV *pluginData = (LowpassCV *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_ofs = *(pluginData->freq_ofs);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    float reso_ofs = *(pluginData->reso_ofs);
-    float *freq_in = pluginData->freq_in;
-    float *reso_in = pluginData->reso_in;
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f0 = freq_ofs;
-    q0 = reso_ofs;
-    if (!(freq_in || reso_in)) {
-        f = f0 * freq_pitch;
-        if (f < MIN_FREQ)
-            f = MIN_FREQ;
-        if (f > MAX_FREQ)
-            f = MAX_FREQ;
-        q = q0;
-        if (q < Q_MIN)
-            q = Q_MIN;
-        if (q > Q_MAX)
-            q = Q_MAX;
-        iv_sin = sin(pi2_rate * f);
-        iv_cos = cos(pi2_rate * f);
-        iv_alpha = iv_sin/(Q_SCALE * q);
-        b0 = (1.0 - iv_cos) / 2.0;
-        b1 = 1.0 - iv_cos;
-        b2 = b0;
-        a0 = 1.0 + iv_alpha;
-        a1 = -2.0 * iv_cos;
-        a2 = 1.0 - iv_alpha;
-        inv_a0 = 1.0 / a0;
-        for (l1 = 0; l1 < sample_count; l1++) {
-            out = inv_a0 * (gain
-                * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                    - a1 * buf[2] - a2 * buf[3]);
-            buf[1] = buf[0];
-            buf[0] = input[l1];
-            buf[3] = buf[2];
-            buf[2] = output[l1] = out;
-        }
-    }
-    else {
-        if (!reso_in) {
-            q = q0;
-            if (q < Q_MIN)
-                q = Q_MIN;
-            if (q > Q_MAX)
-                q = Q_MAX;
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in[l1] > 0)
-                    ? (freq_in[l1] * MAX_FREQ
-                        + f0 - MIN_FREQ) * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                b0 = (1.0 - iv_cos) / 2.0;
-                b1 = 1.0 - iv_cos;
-                b2 = b0;
-                a0 = 1.0 + iv_alpha;
-                a1 = -2.0 * iv_cos;
-                a2 = 1.0 - iv_alpha;
-                out = 1.0 / a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
-        else {
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in && (freq_in[l1] > 0))
-                    ? (freq_in[l1] * MAX_FREQ + f0 - MIN_FREQ)
-                        * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                q = q0  + reso_in[l1];
-                if (q < Q_MIN)
-                    q = Q_MIN;
-                if (q > Q_MAX)
-                    q = Q_MAX;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                b0 = (1.0 - iv_cos) / 2.0;
-                b1 = 1.0 - iv_cos;
-                b2 = b0;
-                a0 = 1.0 + iv_alpha;
-                a1 = -2.0 * iv_cos;
-                a2 = 1.0 - iv_alpha;
-                inv_a0 = 1.0 / a0;
-                out = inv_a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    int conn;
+    if (count) {
+        conn = cvActiveConnections(pluginData->freq_in, pluginData->reso_in,
+                                   NULL, count);
+        LowpassCVKernels[conn](instance, count);
     }
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initLowpassCV()
@@ -300,6 +211,99 @@ static void initLowpassCV()
     LowpassCVDescriptor->extension_data =   NULL;
 }
 
+static LV2_Handle instantiateLowpassMulti(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltMulti(descriptor, s_rate, LowpassMultiDescriptor, 0);
+}
+
+static VCF_SIMD void runLowpassMulti(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltMulti((filtMulti *)instance, sample_count, RBJ_LOWPASS);
+}
+
+static void initLowpassMulti(int index)
+{
+    LowpassMultiDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    LowpassMultiDescriptor[index]->URI =              LowpassMultiURI[index];
+    LowpassMultiDescriptor[index]->activate =         activateFiltMulti;
+    LowpassMultiDescriptor[index]->cleanup =          cleanupFiltMulti;
+    LowpassMultiDescriptor[index]->connect_port =     connectPortFiltMulti;
+    LowpassMultiDescriptor[index]->deactivate =       NULL;
+    LowpassMultiDescriptor[index]->instantiate =      instantiateLowpassMulti;
+    LowpassMultiDescriptor[index]->run =              runLowpassMulti;
+    LowpassMultiDescriptor[index]->extension_data =   NULL;
+}
+
+static LV2_Handle instantiateLowpassVoices(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltVoices(descriptor, s_rate,
+                                 LowpassVoicesDescriptor, 0);
+}
+
+static VCF_SIMD void runLowpassVoices(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltVoices((filtVoices *)instance, sample_count, RBJ_LOWPASS);
+}
+
+static void initLowpassVoices(int index)
+{
+    LowpassVoicesDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    LowpassVoicesDescriptor[index]->URI =              LowpassVoicesURI[index];
+    LowpassVoicesDescriptor[index]->activate =         activateFiltVoices;
+    LowpassVoicesDescriptor[index]->cleanup =          cleanupFiltVoices;
+    LowpassVoicesDescriptor[index]->connect_port =     connectPortFiltVoices;
+    LowpassVoicesDescriptor[index]->deactivate =       NULL;
+    LowpassVoicesDescriptor[index]->instantiate =      instantiateLowpassVoices;
+    LowpassVoicesDescriptor[index]->run =              runLowpassVoices;
+    LowpassVoicesDescriptor[index]->extension_data =   NULL;
+}
+
+static inline void runLowpassSVFConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltSVFConn((filtSVF *)instance, sample_count, RBJ_LOWPASS, conn);
+}
+
+CV_KERNELS_NO_DBGAIN(LowpassSVFKernels, runLowpassSVFConn)
+
+static LV2_Handle instantiateLowpassSVF(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltSVF(s_rate, 0);
+}
+
+static void runLowpassSVF(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltSVF((filtSVF *)instance, sample_count, LowpassSVFKernels);
+}
+
+static void initLowpassSVF()
+{
+    LowpassSVFDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    LowpassSVFDescriptor->URI =              LOWPASSSVF_URI;
+    LowpassSVFDescriptor->activate =         activateFiltSVF;
+    LowpassSVFDescriptor->cleanup =          cleanupFiltSVF;
+    LowpassSVFDescriptor->connect_port =     connectPortFiltSVF;
+    LowpassSVFDescriptor->deactivate =       NULL;
+    LowpassSVFDescriptor->instantiate =      instantiateLowpassSVF;
+    LowpassSVFDescriptor->run =              runLowpassSVF;
+    LowpassSVFDescriptor->extension_data =   NULL;
+}
+
 LV2_SYMBOL_EXPORT
 const LV2_Descriptor *lv2_descriptor(uint32_t index)
 {
@@ -312,6 +316,23 @@ const LV2_Descriptor *lv2_descriptor(uint32_t index)
             if (!LowpassCVDescriptor)
                 initLowpassCV();
             return LowpassCVDescriptor;
+        case 2:
+        case 3:
+        case 4:
+        case 5:
+            if (!LowpassMultiDescriptor[index - 2])
+                initLowpassMulti(index - 2);
+            return LowpassMultiDescriptor[index - 2];
+        case 6:
+        case 7:
+        case 8:
+            if (!LowpassVoicesDescriptor[index - 6])
+                initLowpassVoices(index - 6);
+            return LowpassVoicesDescriptor[index - 6];
+        case 9:
+            if (!LowpassSVFDescriptor)
+                initLowpassSVF();
+            return LowpassSVFDescriptor;
     }
     return NULL;
 }
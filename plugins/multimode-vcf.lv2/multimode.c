@@ -0,0 +1,93 @@
+/******************* Multimode, state variable filter ********************/
+/*  Lowpass, highpass, bandpass and notch from one core, see
+    filter_multimode.h
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <lv2.h>
+
+#include "vcf.h"
+#include "filter_multimode.h"
+
+#define MULTIMODE_URI   "http://jwm-art.net/lv2/vcf/multimode";
+#define MULTIMODECV_URI "http://jwm-art.net/lv2/vcf/multimode_cv";
+
+static LV2_Descriptor *MultimodeDescriptor = NULL;
+static LV2_Descriptor *MultimodeCVDescriptor = NULL;
+
+static inline void runMultimodeConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltMultimodeConn((filtMultimode *)instance, sample_count, conn);
+}
+
+CV_KERNELS(MultimodeKernels, runMultimodeConn)
+
+static LV2_Handle instantiateMultimode(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltMultimode(s_rate, 0);
+}
+
+static LV2_Handle instantiateMultimodeCV(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltMultimode(s_rate, 1);
+}
+
+static void runMultimode(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltMultimode((filtMultimode *)instance, sample_count,
+                     MultimodeKernels);
+}
+
+static void initMultimode()
+{
+    MultimodeDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    MultimodeDescriptor->URI =              MULTIMODE_URI;
+    MultimodeDescriptor->activate =         activateFiltMultimode;
+    MultimodeDescriptor->cleanup =          cleanupFiltMultimode;
+    MultimodeDescriptor->connect_port =     connectPortFiltMultimode;
+    MultimodeDescriptor->deactivate =       NULL;
+    MultimodeDescriptor->instantiate =      instantiateMultimode;
+    MultimodeDescriptor->run =              runMultimode;
+    MultimodeDescriptor->extension_data =   NULL;
+}
+
+static void initMultimodeCV()
+{
+    MultimodeCVDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    MultimodeCVDescriptor->URI =              MULTIMODECV_URI;
+    MultimodeCVDescriptor->activate =         activateFiltMultimode;
+    MultimodeCVDescriptor->cleanup =          cleanupFiltMultimode;
+    MultimodeCVDescriptor->connect_port =     connectPortFiltMultimode;
+    MultimodeCVDescriptor->deactivate =       NULL;
+    MultimodeCVDescriptor->instantiate =      instantiateMultimodeCV;
+    MultimodeCVDescriptor->run =              runMultimode;
+    MultimodeCVDescriptor->extension_data =   NULL;
+}
+
+LV2_SYMBOL_EXPORT
+const LV2_Descriptor *lv2_descriptor(uint32_t index)
+{
+    switch(index){
+        case 0:
+            if (!MultimodeDescriptor)
+                initMultimode();
+            return MultimodeDescriptor;
+        case 1:
+            if (!MultimodeCVDescriptor)
+                initMultimodeCV();
+            return MultimodeCVDescriptor;
+    }
+    return NULL;
+}
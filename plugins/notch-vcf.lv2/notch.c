@@ -9,12 +9,35 @@
 
 #include "vcf.h"
 #include "filter_type2.h"
+#include "filter_multi.h"
+#include "filter_voices.h"
+#include "filter_svf.h"
+#include "filter_hum.h"
 
-#define NOTCH_URI   "http://jwm-art.net/lv2/vcf/notch";
-#define NOTCHCV_URI "http://jwm-art.net/lv2/vcf/notch_cv";
+#define NOTCH_URI    "http://jwm-art.net/lv2/vcf/notch";
+#define NOTCHCV_URI  "http://jwm-art.net/lv2/vcf/notch_cv";
+#define NOTCHSVF_URI "http://jwm-art.net/lv2/vcf/notch_svf";
+#define NOTCHHUM_URI "http://jwm-art.net/lv2/vcf/notch_hum";
 
 static LV2_Descriptor *NotchDescriptor = NULL;
 static LV2_Descriptor *NotchCVDescriptor = NULL;
+static LV2_Descriptor *NotchSVFDescriptor = NULL;
+static LV2_Descriptor *NotchHumDescriptor = NULL;
+static LV2_Descriptor *NotchMultiDescriptor[MULTI_DESCRIPTORS];
+static LV2_Descriptor *NotchVoicesDescriptor[VOICES_DESCRIPTORS];
+
+static const char *NotchMultiURI[MULTI_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/notch_x2",
+    "http://jwm-art.net/lv2/vcf/notch_x8",
+    "http://jwm-art.net/lv2/vcf/notch_x16",
+    "http://jwm-art.net/lv2/vcf/notch_x64"
+};
+
+static const char *NotchVoicesURI[VOICES_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/notch_voices8",
+    "http://jwm-art.net/lv2/vcf/notch_voices16",
+    "http://jwm-art.net/lv2/vcf/notch_voices32"
+};
 
 typedef filtType2    Notch;
 typedef filtType2_cv NotchCV;
@@ -35,6 +58,9 @@ static void connectPortNotch(
         case 3: plugin->freq_ofs = data;    break;
         case 4: plugin->freq_pitch = data;  break;
         case 5: plugin->reso_ofs = data;    break;
+        case 6: plugin->sections = data;    break;
+        case 7: plugin->bypass.enabled = data; break;
+        case 8: plugin->params.control = data; break;
     }
 }
 
@@ -46,6 +72,13 @@ static LV2_Handle instantiateNotch(
 {
     Notch* plugin_data = (Notch*)malloc(sizeof(Notch));
     plugin_data->rate = s_rate;
+    plugin_data->controls.valid = 0;
+    plugin_data->sections = NULL;
+    plugin_data->response = NULL;
+    sosInit(&plugin_data->sos);
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    paramEventsInit(&plugin_data->params, features);
     return (LV2_Handle)plugin_data;
 }
 
@@ -53,57 +86,18 @@ static void activateNotch(LV2_Handle instance)
 {
     Notch *plugin_data = (Notch *)instance;
     int l1;
-    for (l1 = 0; l1 < 4; l1++)
+    for (l1 = 0; l1 < 4 * SOS_MAX_SECTIONS; l1++)
       plugin_data->buf[l1] = 0;
 }
 
-static void runNotch(LV2_Handle instance, uint32_t sample_count)
+static VCF_SIMD void runNotch(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    float out;
-    double f, q, pi2_rate;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha;
-    double inv_a0, a0, a1, a2, b0, b1, b2;
     Notch *pluginData = (Notch *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f = *(pluginData->freq_ofs) * freq_pitch;
-    if (f < MIN_FREQ)
-        f = MIN_FREQ;
-    if (f > MAX_FREQ)
-        f = MAX_FREQ;
-    q = *(pluginData->reso_ofs);
-    if (q < Q_MIN)
-        q = Q_MIN;
-    if (q > Q_MAX)
-        q = Q_MAX;
-    iv_sin = sin(pi2_rate * f);
-    iv_cos = cos(pi2_rate * f);
-    iv_alpha = iv_sin / (Q_SCALE * q);
-    b0 = 1;
-    b1 = -2.0 * iv_cos;
-    b2 = 1;
-    a0 = 1.0 + iv_alpha;
-    a1 = -2.0 * iv_cos;
-    a2 = 1.0 - iv_alpha;
-    inv_a0 = 1.0 / a0;
-    for (l1 = 0; l1 < sample_count; l1++) {
-        out = inv_a0 * (gain
-            * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                - a1 * buf[2] - a2 * buf[3]);
-        buf[1] = buf[0];
-        buf[0] = input[l1];
-        buf[3] = buf[2];
-        buf[2] = output[l1] = out;
-    }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    runFiltType2(pluginData, count, RBJ_NOTCH);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initNotch()
@@ -122,9 +116,19 @@ static void initNotch()
 
 static void cleanupNotchCV(LV2_Handle instance)
 {
+    NotchCV *plugin_data = (NotchCV *)instance;
+    coefTableRelease(plugin_data->table);
     free(instance);
 }
 
+static inline void runNotchCVConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltType2CV((NotchCV *)instance, sample_count, RBJ_NOTCH, conn);
+}
+
+CV_KERNELS_NO_DBGAIN(NotchCVKernels, runNotchCVConn)
+
 static void connectPortNotchCV(
     LV2_Handle instance, uint32_t port, void *data)
 {
@@ -138,6 +142,11 @@ static void connectPortNotchCV(
         case 5: plugin->freq_in = data;     break;
         case 6: plugin->reso_ofs = data;    break;
         case 7: plugin->reso_in = data;     break;
+        case 8: plugin->mod_rate = data;    break;
+        case 9: plugin->sections = data;    break;
+        case 10: plugin->bypass.enabled = data; break;
+        default: modSourceConnect(&plugin->mod, port - 11, data);
+                 break;
     }
 }
 
@@ -149,6 +158,19 @@ static LV2_Handle instantiateNotchCV(
 {
     NotchCV* plugin_data = (NotchCV*)malloc(sizeof(NotchCV));
     plugin_data->rate = s_rate;
+    plugin_data->freq_in = NULL;
+    plugin_data->reso_in = NULL;
+    plugin_data->sections = NULL;
+    plugin_data->response = NULL;
+    sosInit(&plugin_data->sos);
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    modSourceInit(&plugin_data->mod, s_rate, features);
+    plugin_data->table = coefTableAcquire(s_rate);
+    if (!plugin_data->table) {
+        free(plugin_data);
+        return NULL;
+    }
     return (LV2_Handle)plugin_data;
 }
 
@@ -156,134 +178,24 @@ static void activateNotchCV(LV2_Handle instance)
 {
     NotchCV *plugin_data = (NotchCV *)instance;
     int l1;
-    for (l1 = 0; l1 < 4; l1++)
+    for (l1 = 0; l1 < 4 * SOS_MAX_SECTIONS; l1++)
       plugin_data->buf[l1] = 0;
+    plugin_data->coefs_valid = 0;
 }
 
 static void runNotchCV(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    float out;
-    double f0, q0, f, q, pi2_rate;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha;
-    double inv_a0, a0, a1, a2, b0, b1, b2;
     NotchCV *pluginData = (NotchCV *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_ofs = *(pluginData->freq_ofs);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    float reso_ofs = *(pluginData->reso_ofs);
-    float *freq_in = pluginData->freq_in;
-    float *reso_in = pluginData->reso_in;
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f0 = freq_ofs;
-    q0 = reso_ofs;
-    if (!(freq_in || reso_in)) {
-        f = f0 * freq_pitch;
-        if (f < MIN_FREQ)
-            f = MIN_FREQ;
-        if (f > MAX_FREQ)
-            f = MAX_FREQ;
-        q = q0;
-        if (q < Q_MIN)
-            q = Q_MIN;
-        if (q > Q_MAX)
-            q = Q_MAX;
-        iv_sin = sin(pi2_rate * f);
-        iv_cos = cos(pi2_rate * f);
-        iv_alpha = iv_sin/(Q_SCALE * q);
-        b0 = 1;
-        b1 = -2.0 * iv_cos;
-        b2 = 1;
-        a0 = 1.0 + iv_alpha;
-        a1 = -2.0 * iv_cos;
-        a2 = 1.0 - iv_alpha;
-        inv_a0 = 1.0 / a0;
-        for (l1 = 0; l1 < sample_count; l1++) {
-            out = inv_a0 * (gain
-                * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                    - a1 * buf[2] - a2 * buf[3]);
-            buf[1] = buf[0];
-            buf[0] = input[l1];
-            buf[3] = buf[2];
-            buf[2] = output[l1] = out;
-        }
-    }
-    else {
-        if (!reso_in) {
-            q = q0;
-            if (q < Q_MIN)
-                q = Q_MIN;
-            if (q > Q_MAX)
-                q = Q_MAX;
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in[l1] > 0)
-                    ? (freq_in[l1] * MAX_FREQ
-                        + f0 - MIN_FREQ) * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                b0 = 1;
-                b1 = -2.0 * iv_cos;
-                b2 = 1;
-                a0 = 1.0 + iv_alpha;
-                a1 = -2.0 * iv_cos;
-                a2 = 1.0 - iv_alpha;
-                out = 1.0 / a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
-        else {
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in && (freq_in[l1] > 0))
-                    ? (freq_in[l1] * MAX_FREQ + f0 - MIN_FREQ)
-                        * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                q = q0  + reso_in[l1];
-                if (q < Q_MIN)
-                    q = Q_MIN;
-                if (q > Q_MAX)
-                    q = Q_MAX;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                b0 = 1;
-                b1 = -2 * iv_cos;
-                b2 = 1;
-                a0 = 1.0 + iv_alpha;
-                a1 = -2.0 * iv_cos;
-                a2 = 1.0 - iv_alpha;
-                inv_a0 = 1.0 / a0;
-                out = inv_a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    int conn;
+    if (count) {
+        conn = cvActiveConnections(pluginData->freq_in, pluginData->reso_in,
+                                   NULL, count);
+        NotchCVKernels[conn](instance, count);
     }
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initNotchCV()
@@ -300,6 +212,134 @@ static void initNotchCV()
     NotchCVDescriptor->extension_data =   NULL;
 }
 
+static LV2_Handle instantiateNotchMulti(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltMulti(descriptor, s_rate, NotchMultiDescriptor, 0);
+}
+
+static VCF_SIMD void runNotchMulti(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltMulti((filtMulti *)instance, sample_count, RBJ_NOTCH);
+}
+
+static void initNotchMulti(int index)
+{
+    NotchMultiDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    NotchMultiDescriptor[index]->URI =              NotchMultiURI[index];
+    NotchMultiDescriptor[index]->activate =         activateFiltMulti;
+    NotchMultiDescriptor[index]->cleanup =          cleanupFiltMulti;
+    NotchMultiDescriptor[index]->connect_port =     connectPortFiltMulti;
+    NotchMultiDescriptor[index]->deactivate =       NULL;
+    NotchMultiDescriptor[index]->instantiate =      instantiateNotchMulti;
+    NotchMultiDescriptor[index]->run =              runNotchMulti;
+    NotchMultiDescriptor[index]->extension_data =   NULL;
+}
+
+static LV2_Handle instantiateNotchVoices(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltVoices(descriptor, s_rate, NotchVoicesDescriptor, 0);
+}
+
+static VCF_SIMD void runNotchVoices(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltVoices((filtVoices *)instance, sample_count, RBJ_NOTCH);
+}
+
+static void initNotchVoices(int index)
+{
+    NotchVoicesDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    NotchVoicesDescriptor[index]->URI =              NotchVoicesURI[index];
+    NotchVoicesDescriptor[index]->activate =         activateFiltVoices;
+    NotchVoicesDescriptor[index]->cleanup =          cleanupFiltVoices;
+    NotchVoicesDescriptor[index]->connect_port =     connectPortFiltVoices;
+    NotchVoicesDescriptor[index]->deactivate =       NULL;
+    NotchVoicesDescriptor[index]->instantiate =      instantiateNotchVoices;
+    NotchVoicesDescriptor[index]->run =              runNotchVoices;
+    NotchVoicesDescriptor[index]->extension_data =   NULL;
+}
+
+static inline void runNotchSVFConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltSVFConn((filtSVF *)instance, sample_count, RBJ_NOTCH, conn);
+}
+
+CV_KERNELS_NO_DBGAIN(NotchSVFKernels, runNotchSVFConn)
+
+static LV2_Handle instantiateNotchSVF(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltSVF(s_rate, 0);
+}
+
+static void runNotchSVF(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltSVF((filtSVF *)instance, sample_count, NotchSVFKernels);
+}
+
+static void initNotchSVF()
+{
+    NotchSVFDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    NotchSVFDescriptor->URI =              NOTCHSVF_URI;
+    NotchSVFDescriptor->activate =         activateFiltSVF;
+    NotchSVFDescriptor->cleanup =          cleanupFiltSVF;
+    NotchSVFDescriptor->connect_port =     connectPortFiltSVF;
+    NotchSVFDescriptor->deactivate =       NULL;
+    NotchSVFDescriptor->instantiate =      instantiateNotchSVF;
+    NotchSVFDescriptor->run =              runNotchSVF;
+    NotchSVFDescriptor->extension_data =   NULL;
+}
+
+static LV2_Handle instantiateNotchHum(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltHum(s_rate);
+}
+
+static VCF_SIMD void runNotchHum(LV2_Handle instance, uint32_t sample_count)
+{
+    filtHum *pluginData = (filtHum *)instance;
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    if (count)
+        runFiltHum(pluginData, count);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
+    if (pluginData->hum_freq)
+        *(pluginData->hum_freq) = pluginData->freq;
+}
+
+static void initNotchHum()
+{
+    NotchHumDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    NotchHumDescriptor->URI =              NOTCHHUM_URI;
+    NotchHumDescriptor->activate =         activateFiltHum;
+    NotchHumDescriptor->cleanup =          cleanupFiltHum;
+    NotchHumDescriptor->connect_port =     connectPortFiltHum;
+    NotchHumDescriptor->deactivate =       NULL;
+    NotchHumDescriptor->instantiate =      instantiateNotchHum;
+    NotchHumDescriptor->run =              runNotchHum;
+    NotchHumDescriptor->extension_data =   NULL;
+}
+
 LV2_SYMBOL_EXPORT
 const LV2_Descriptor *lv2_descriptor(uint32_t index)
 {
@@ -312,6 +352,27 @@ const LV2_Descriptor *lv2_descriptor(uint32_t index)
             if (!NotchCVDescriptor)
                 initNotchCV();
             return NotchCVDescriptor;
+        case 2:
+        case 3:
+        case 4:
+        case 5:
+            if (!NotchMultiDescriptor[index - 2])
+                initNotchMulti(index - 2);
+            return NotchMultiDescriptor[index - 2];
+        case 6:
+        case 7:
+        case 8:
+            if (!NotchVoicesDescriptor[index - 6])
+                initNotchVoices(index - 6);
+            return NotchVoicesDescriptor[index - 6];
+        case 9:
+            if (!NotchSVFDescriptor)
+                initNotchSVF();
+            return NotchSVFDescriptor;
+        case 10:
+            if (!NotchHumDescriptor)
+                initNotchHum();
+            return NotchHumDescriptor;
     }
     return NULL;
 }
@@ -9,12 +9,35 @@
 
 #include "vcf.h"
 #include "filter_type3.h"
+#include "filter_multi.h"
+#include "filter_voices.h"
+#include "filter_svf.h"
+#include "filter_dynamic.h"
 
-#define PEAKEQ_URI   "http://jwm-art.net/lv2/vcf/peak_eq";
-#define PEAKEQCV_URI "http://jwm-art.net/lv2/vcf/peak_eq_cv";
+#define PEAKEQ_URI    "http://jwm-art.net/lv2/vcf/peak_eq";
+#define PEAKEQCV_URI  "http://jwm-art.net/lv2/vcf/peak_eq_cv";
+#define PEAKEQSVF_URI "http://jwm-art.net/lv2/vcf/peak_eq_svf";
+#define PEAKEQDYN_URI "http://jwm-art.net/lv2/vcf/peak_eq_dyn";
 
 static LV2_Descriptor *PeakEQDescriptor = NULL;
 static LV2_Descriptor *PeakEQCVDescriptor = NULL;
+static LV2_Descriptor *PeakEQSVFDescriptor = NULL;
+static LV2_Descriptor *PeakEQDynDescriptor = NULL;
+static LV2_Descriptor *PeakEQMultiDescriptor[MULTI_DESCRIPTORS];
+static LV2_Descriptor *PeakEQVoicesDescriptor[VOICES_DESCRIPTORS];
+
+static const char *PeakEQMultiURI[MULTI_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/peak_eq_x2",
+    "http://jwm-art.net/lv2/vcf/peak_eq_x8",
+    "http://jwm-art.net/lv2/vcf/peak_eq_x16",
+    "http://jwm-art.net/lv2/vcf/peak_eq_x64"
+};
+
+static const char *PeakEQVoicesURI[VOICES_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/peak_eq_voices8",
+    "http://jwm-art.net/lv2/vcf/peak_eq_voices16",
+    "http://jwm-art.net/lv2/vcf/peak_eq_voices32"
+};
 
 typedef filtType3    PeakEQ;
 typedef filtType3_cv PeakEQCV;
@@ -36,6 +59,8 @@ static void connectPortPeakEQ(
         case 4: plugin->freq_pitch = data;  break;
         case 5: plugin->reso_ofs = data;    break;
         case 6: plugin->dBgain_ofs = data;  break;
+        case 7: plugin->bypass.enabled = data; break;
+        case 8: plugin->params.control = data; break;
     }
 }
 
@@ -47,6 +72,10 @@ static LV2_Handle instantiatePeakEQ(
 {
     PeakEQ* plugin_data = (PeakEQ*)malloc(sizeof(PeakEQ));
     plugin_data->rate = s_rate;
+    plugin_data->controls.valid = 0;
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    paramEventsInit(&plugin_data->params, features);
     return (LV2_Handle)plugin_data;
 }
 
@@ -58,56 +87,14 @@ static void activatePeakEQ(LV2_Handle instance)
       plugin_data->buf[l1] = 0;
 }
 
-static void runPeakEQ(LV2_Handle instance, uint32_t sample_count)
+static VCF_SIMD void runPeakEQ(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    double f, q, pi2_rate;
-    float A;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha;
-    double inv_a0, a0, a1, a2, b0, b1, b2;
     PeakEQ *pluginData = (PeakEQ *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    float dBgain = *(pluginData->dBgain_ofs);
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f =  *(pluginData->freq_ofs) * freq_pitch;
-    if (f < MIN_FREQ)
-        f = MIN_FREQ;
-    if (f > MAX_FREQ)
-        f = MAX_FREQ;
-    q = *(pluginData->reso_ofs);
-    if (q < Q_MIN)
-        q = Q_MIN;
-    if (q > Q_MAX)
-        q = Q_MAX;
-    iv_sin = sin(pi2_rate * f);
-    iv_cos = cos(pi2_rate * f);
-    iv_alpha = iv_sin / (Q_SCALE * q);
-    A = exp(dBgain / 40.0 * log(10.0));
-    b0 = 1.0 + iv_alpha * A;
-    b1 = -2.0 * iv_cos;
-    b2 = 1.0 - iv_alpha * A;
-    a0 = 1.0 + iv_alpha / A;
-    a1 = -2.0 * iv_cos;
-    a2 = 1.0 - iv_alpha / A;
-    inv_a0 = 1.0 / a0;
-    float out;
-    for (l1 = 0; l1 < sample_count; l1++) {
-        out = inv_a0 * (gain
-            * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                - a1 * buf[2] - a2 * buf[3]);
-        buf[1] = buf[0];
-        buf[0] = input[l1];
-        buf[3] = buf[2];
-        buf[2] = output[l1] = out;
-    }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    runFiltType3(pluginData, count, RBJ_PEAK_EQ);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initPeakEQ()
@@ -126,9 +113,19 @@ static void initPeakEQ()
 
 static void cleanupPeakEQCV(LV2_Handle instance)
 {
+    PeakEQCV *plugin_data = (PeakEQCV *)instance;
+    coefTableRelease(plugin_data->table);
     free(instance);
 }
 
+static inline void runPeakEQCVConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltType3CV((PeakEQCV *)instance, sample_count, RBJ_PEAK_EQ, conn);
+}
+
+CV_KERNELS(PeakEQCVKernels, runPeakEQCVConn)
+
 static void connectPortPeakEQCV(
     LV2_Handle instance, uint32_t port, void *data)
 {
@@ -144,6 +141,10 @@ static void connectPortPeakEQCV(
         case 7: plugin->reso_in = data;     break;
         case 8: plugin->dBgain_ofs = data;  break;
         case 9: plugin->dBgain_in = data;   break;
+        case 10: plugin->mod_rate = data;   break;
+        case 11: plugin->bypass.enabled = data; break;
+        default: modSourceConnect(&plugin->mod, port - 12, data);
+                 break;
     }
 }
 
@@ -155,6 +156,17 @@ static LV2_Handle instantiatePeakEQCV(
 {
     PeakEQCV* plugin_data = (PeakEQCV*)malloc(sizeof(PeakEQCV));
     plugin_data->rate = s_rate;
+    plugin_data->freq_in = NULL;
+    plugin_data->reso_in = NULL;
+    plugin_data->dBgain_in = NULL;
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    modSourceInit(&plugin_data->mod, s_rate, features);
+    plugin_data->table = coefTableAcquire(s_rate);
+    if (!plugin_data->table) {
+        free(plugin_data);
+        return NULL;
+    }
     return (LV2_Handle)plugin_data;
 }
 
@@ -164,142 +176,22 @@ static void activatePeakEQCV(LV2_Handle instance)
     int l1;
     for (l1 = 0; l1 < 4; l1++)
         plugin_data->buf[l1] = 0;
+    plugin_data->coefs_valid = 0;
 }
 
 static void runPeakEQCV(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    float out;
-    double f0, q0, f, q, pi2_rate;
-    float A, dBgain;
-    double *buf;
-    double iv_sin, iv_cos, iv_alpha;
-    double inv_a0, a0, a1, a2, b0, b1, b2;
     PeakEQCV *pluginData = (PeakEQCV *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_ofs = *(pluginData->freq_ofs);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    float reso_ofs = *(pluginData->reso_ofs);
-    float *freq_in = pluginData->freq_in;
-    float *reso_in = pluginData->reso_in;
-    float dBgain_ofs = *(pluginData->dBgain_ofs);
-    float *dBgain_in = pluginData->dBgain_in;
-    pi2_rate = 2.0 * M_PI / pluginData->rate;
-    buf = pluginData->buf;
-    f0 = freq_ofs;
-    q0 = reso_ofs;
-    if (!(freq_in || reso_in || dBgain_in)) {
-        f = f0 * freq_pitch;
-        if (f < MIN_FREQ)
-            f = MIN_FREQ;
-        if (f > MAX_FREQ)
-            f = MAX_FREQ;
-        q = q0;
-        if (q < Q_MIN)
-            q = Q_MIN;
-        if (q > Q_MAX)
-            q = Q_MAX;
-        dBgain = dBgain_ofs;
-        iv_sin = sin(pi2_rate * f);
-        iv_cos = cos(pi2_rate * f);
-        iv_alpha = iv_sin/(Q_SCALE * q);
-        A = exp(dBgain/40.0 * log(10.0));
-        b0 = 1.0 + iv_alpha * A;
-        b1 = -2.0 * iv_cos;
-        b2 = 1.0 - iv_alpha * A;
-        a0 = 1.0 + iv_alpha / A;
-        a1 = -2.0 * iv_cos;
-        a2 = 1.0 - iv_alpha / A;
-        inv_a0 = 1.0 / a0;
-        for (l1 = 0; l1 < sample_count; l1++) {
-            out = inv_a0 * (gain
-                * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                    - a1 * buf[2] - a2 * buf[3]);
-            buf[1] = buf[0];
-            buf[0] = input[l1];
-            buf[3] = buf[2];
-            buf[2] = output[l1] = out;
-        }
-    }
-    else {
-        if (!reso_in || dBgain_in) {
-            q = q0;
-            if (q < Q_MIN)
-                q = Q_MIN;
-            if (q > Q_MAX)
-                q = Q_MAX;
-            dBgain = dBgain_ofs;
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in[l1] > 0)
-                    ? (freq_in[l1] * MAX_FREQ
-                        + f0 - MIN_FREQ) * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                A = exp(dBgain/40.0 * log(10.0));
-                b0 = 1.0 + iv_alpha * A;
-                b1 = -2.0 * iv_cos;
-                b2 = 1.0 - iv_alpha * A;
-                a0 = 1.0 + iv_alpha / A;
-                a1 = -2.0 * iv_cos;
-                a2 = 1.0 - iv_alpha / A;
-                inv_a0 = 1.0 / a0;
-                out = inv_a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
-        else {
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in && (freq_in[l1] > 0))
-                    ? (freq_in[l1] * MAX_FREQ + f0 - MIN_FREQ)
-                        * freq_pitch
-                    : f0 * freq_pitch;
-                if (f < MIN_FREQ)
-                    f = MIN_FREQ;
-                if (f > MAX_FREQ)
-                    f = MAX_FREQ;
-                q = q0  + reso_in[l1];
-                if (q < Q_MIN)
-                    q = Q_MIN;
-                if (q > Q_MAX)
-                    q = Q_MAX;
-                dBgain = (dBgain_in) ? dBgain_ofs + DBGAIN_SCALE * dBgain_in[l1] : dBgain_ofs;
-                iv_sin = sin(pi2_rate * f);
-                iv_cos = cos(pi2_rate * f);
-                iv_alpha = iv_sin/(Q_SCALE * q);
-                A = exp(dBgain/40.0 * log(10.0));
-                b0 = 1.0 + iv_alpha * A;
-                b1 = -2.0 * iv_cos;
-                b2 = 1.0 - iv_alpha * A;
-                a0 = 1.0 + iv_alpha / A;
-                a1 = -2.0 * iv_cos;
-                a2 = 1.0 - iv_alpha / A;
-                inv_a0 = 1.0 / a0;
-                out = inv_a0 * (gain
-                    * (b0 * input[l1] + b1 * buf[0] + b2 * buf[1])
-                        - a1 * buf[2] - a2 * buf[3]);
-                buf[1] = buf[0];
-                buf[0] = input[l1];
-                buf[3] = buf[2];
-                buf[2] = output[l1] = out;
-            }
-        }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    int conn;
+    if (count) {
+        conn = cvActiveConnections(pluginData->freq_in, pluginData->reso_in,
+                                   pluginData->dBgain_in, count);
+        PeakEQCVKernels[conn](instance, count);
     }
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initPeakEQCV()
@@ -316,6 +208,133 @@ static void initPeakEQCV()
     PeakEQCVDescriptor->extension_data =   NULL;
 }
 
+static LV2_Handle instantiatePeakEQMulti(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltMulti(descriptor, s_rate, PeakEQMultiDescriptor, 1);
+}
+
+static VCF_SIMD void runPeakEQMulti(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltMulti((filtMulti *)instance, sample_count, RBJ_PEAK_EQ);
+}
+
+static void initPeakEQMulti(int index)
+{
+    PeakEQMultiDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    PeakEQMultiDescriptor[index]->URI =              PeakEQMultiURI[index];
+    PeakEQMultiDescriptor[index]->activate =         activateFiltMulti;
+    PeakEQMultiDescriptor[index]->cleanup =          cleanupFiltMulti;
+    PeakEQMultiDescriptor[index]->connect_port =     connectPortFiltMulti;
+    PeakEQMultiDescriptor[index]->deactivate =       NULL;
+    PeakEQMultiDescriptor[index]->instantiate =      instantiatePeakEQMulti;
+    PeakEQMultiDescriptor[index]->run =              runPeakEQMulti;
+    PeakEQMultiDescriptor[index]->extension_data =   NULL;
+}
+
+static LV2_Handle instantiatePeakEQVoices(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltVoices(descriptor, s_rate,
+                                 PeakEQVoicesDescriptor, 1);
+}
+
+static VCF_SIMD void runPeakEQVoices(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltVoices((filtVoices *)instance, sample_count, RBJ_PEAK_EQ);
+}
+
+static void initPeakEQVoices(int index)
+{
+    PeakEQVoicesDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    PeakEQVoicesDescriptor[index]->URI =              PeakEQVoicesURI[index];
+    PeakEQVoicesDescriptor[index]->activate =         activateFiltVoices;
+    PeakEQVoicesDescriptor[index]->cleanup =          cleanupFiltVoices;
+    PeakEQVoicesDescriptor[index]->connect_port =     connectPortFiltVoices;
+    PeakEQVoicesDescriptor[index]->deactivate =       NULL;
+    PeakEQVoicesDescriptor[index]->instantiate =      instantiatePeakEQVoices;
+    PeakEQVoicesDescriptor[index]->run =              runPeakEQVoices;
+    PeakEQVoicesDescriptor[index]->extension_data =   NULL;
+}
+
+static inline void runPeakEQSVFConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    runFiltSVFConn((filtSVF *)instance, sample_count, RBJ_PEAK_EQ, conn);
+}
+
+CV_KERNELS(PeakEQSVFKernels, runPeakEQSVFConn)
+
+static LV2_Handle instantiatePeakEQSVF(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltSVF(s_rate, 1);
+}
+
+static void runPeakEQSVF(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltSVF((filtSVF *)instance, sample_count, PeakEQSVFKernels);
+}
+
+static void initPeakEQSVF()
+{
+    PeakEQSVFDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    PeakEQSVFDescriptor->URI =              PEAKEQSVF_URI;
+    PeakEQSVFDescriptor->activate =         activateFiltSVF;
+    PeakEQSVFDescriptor->cleanup =          cleanupFiltSVF;
+    PeakEQSVFDescriptor->connect_port =     connectPortFiltSVF;
+    PeakEQSVFDescriptor->deactivate =       NULL;
+    PeakEQSVFDescriptor->instantiate =      instantiatePeakEQSVF;
+    PeakEQSVFDescriptor->run =              runPeakEQSVF;
+    PeakEQSVFDescriptor->extension_data =   NULL;
+}
+
+static LV2_Handle instantiatePeakEQDyn(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltDynamic(s_rate);
+}
+
+static VCF_SIMD void runPeakEQDyn(LV2_Handle instance, uint32_t sample_count)
+{
+    filtDynamic *pluginData = (filtDynamic *)instance;
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    if (count)
+        runFiltDynamic(pluginData, count, RBJ_PEAK_EQ);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
+}
+
+static void initPeakEQDyn()
+{
+    PeakEQDynDescriptor =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    PeakEQDynDescriptor->URI =              PEAKEQDYN_URI;
+    PeakEQDynDescriptor->activate =         activateFiltDynamic;
+    PeakEQDynDescriptor->cleanup =          cleanupFiltDynamic;
+    PeakEQDynDescriptor->connect_port =     connectPortFiltDynamic;
+    PeakEQDynDescriptor->deactivate =       NULL;
+    PeakEQDynDescriptor->instantiate =      instantiatePeakEQDyn;
+    PeakEQDynDescriptor->run =              runPeakEQDyn;
+    PeakEQDynDescriptor->extension_data =   NULL;
+}
+
 LV2_SYMBOL_EXPORT
 const LV2_Descriptor *lv2_descriptor(uint32_t index)
 {
@@ -328,6 +347,27 @@ const LV2_Descriptor *lv2_descriptor(uint32_t index)
             if (!PeakEQCVDescriptor)
                 initPeakEQCV();
             return PeakEQCVDescriptor;
+        case 2:
+        case 3:
+        case 4:
+        case 5:
+            if (!PeakEQMultiDescriptor[index - 2])
+                initPeakEQMulti(index - 2);
+            return PeakEQMultiDescriptor[index - 2];
+        case 6:
+        case 7:
+        case 8:
+            if (!PeakEQVoicesDescriptor[index - 6])
+                initPeakEQVoices(index - 6);
+            return PeakEQVoicesDescriptor[index - 6];
+        case 9:
+            if (!PeakEQSVFDescriptor)
+                initPeakEQSVF();
+            return PeakEQSVFDescriptor;
+        case 10:
+            if (!PeakEQDynDescriptor)
+                initPeakEQDyn();
+            return PeakEQDynDescriptor;
     }
     return NULL;
 }
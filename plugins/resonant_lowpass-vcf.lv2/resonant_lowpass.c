@@ -15,9 +15,49 @@
 
 static LV2_Descriptor *ResLowpassDescriptor = NULL;
 static LV2_Descriptor *ResLowpassCVDescriptor = NULL;
+static LV2_Descriptor *ResLowpassVoicesDescriptor[VOICES_DESCRIPTORS];
 
-typedef filtType1    ResLowpass;
-typedef filtType1_cv ResLowpassCV;
+static const char *ResLowpassVoicesURI[VOICES_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/resonant_lowpass_voices8",
+    "http://jwm-art.net/lv2/vcf/resonant_lowpass_voices16",
+    "http://jwm-art.net/lv2/vcf/resonant_lowpass_voices32"
+};
+
+typedef filtType1        ResLowpass;
+typedef filtType1_cv     ResLowpassCV;
+typedef filtType1_voices ResLowpassVoices;
+
+/*  One sample of the filter.  The 4-pole mode passes the resonant pair
+    through two more one-pole stages with the same f, so the coefficients
+    are shared and the resonance stays that of a single peak.  poles is
+    expected to be a constant.
+*/
+static inline double tickResLowpass(
+    double *buf, double in, double f, double fa, double fb, int poles)
+{
+    buf[0] = fa * buf[0] + f * (in + fb * (buf[0] - buf[1]));
+    buf[1] = fa * buf[1] + f * buf[0];
+    if (poles == 2)
+        return buf[1];
+    buf[2] = fa * buf[2] + f * buf[1];
+    buf[3] = fa * buf[3] + f * buf[2];
+    return buf[3];
+}
+
+/*  Number of poles selected on the poles port.  In the 2-pole mode the
+    two extra stages follow the output of the pair, so switching to 4
+    poles starts them settled instead of from stale values.
+*/
+static inline int polesResLowpass(const float *poles)
+{
+    return (poles && *poles > 3) ? 4 : 2;
+}
+
+static inline void settleResLowpass(double *buf, int poles)
+{
+    if (poles == 2)
+        buf[2] = buf[3] = buf[1];
+}
 
 static void cleanupResLowpass(LV2_Handle instance)
 {
@@ -35,6 +75,9 @@ static void connectPortResLowpass(
         case 3: plugin->freq_ofs = data;    break;
         case 4: plugin->freq_pitch = data;  break;
         case 5: plugin->reso_ofs = data;    break;
+        case 6: plugin->poles = data;       break;
+        case 7: plugin->bypass.enabled = data; break;
+        case 8: plugin->params.control = data; break;
     }
 }
 
@@ -46,6 +89,11 @@ static LV2_Handle instantiateResLowpass(
 {
     ResLowpass* plugin_data = (ResLowpass*)malloc(sizeof(ResLowpass));
     plugin_data->rate = s_rate;
+    plugin_data->poles = NULL;
+    plugin_data->controls.valid = 0;
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    paramEventsInit(&plugin_data->params, features);
     return (LV2_Handle)plugin_data;
 }
 
@@ -53,43 +101,91 @@ static void activateResLowpass(LV2_Handle instance)
 {
     ResLowpass *plugin_data = (ResLowpass *)instance;
     int l1;
-    for (l1 = 0; l1 < 2; l1++)
+    for (l1 = 0; l1 < 4; l1++)
       plugin_data->buf[l1] = 0;
 }
 
-static void runResLowpass(LV2_Handle instance, uint32_t sample_count)
+/*  len samples from offset on, with the frequency and resonance of
+    values, see runResLowpass().
+*/
+static inline void runResLowpassSpan(ResLowpass *pluginData,
+    uint32_t offset, uint32_t len, int poles, const float *values)
 {
     uint32_t l1;
     double f0, f, q, fa, fb, rate_f;
     double *buf;
-    ResLowpass *pluginData = (ResLowpass *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
+    float *input = pluginData->input + offset;
+    float *output = pluginData->output + offset;
     float gain = *(pluginData->gain);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    rate_f = 44100.0 / pluginData->rate;
-    buf = pluginData->buf;
-    f0 = *(pluginData->freq_ofs) / (double)MAX_FREQ * rate_f * 2.85;;
-    f = f0 * freq_pitch;
-    if (f < 0)
-        f = 0;
-    if (f > 0.9999)
-        f = 0.9999;
-    q = *(pluginData->reso_ofs);
-    if (q < Q_MIN)
-        q = Q_MIN;
-    if (q > Q_MAX)
-        q = Q_MAX;
-    fa = 1.0 - f;
-    fb = q * (1.0 + (1.0 / fa));
-    for (l1 = 0; l1 < sample_count; l1++) {
-        buf[0] = fa * buf[0] + f * (input[l1] + fb * (buf[0] - buf[1]));
-        buf[1] = fa * buf[1] + f * buf[0];
-        output[l1] = gain * buf[1];
+    float controls[3] = {
+        values[PARAM_FREQ], *(pluginData->freq_pitch), values[PARAM_RESO]
+    };
+    fpuMode mode;
+    if (runSilent(input, output, pluginData->buf, 4, len))
+        return;
+    mode = denormalsOff();
+    if (controlsChanged(&pluginData->controls, controls, 3)) {
+        float freq_pitch =
+            (controls[1] > 0)
+                ? 1.0 + controls[1] / 2.0
+                : 1.0 / (1.0 - controls[1] / 2.0);
+        rate_f = 44100.0 / pluginData->rate;
+        f0 = controls[0] / (double)MAX_FREQ * rate_f * 2.85;
+        f = f0 * freq_pitch;
+        if (f < 0)
+            f = 0;
+        if (f > 0.9999)
+            f = 0.9999;
+        q = controls[2];
+        if (q < Q_MIN)
+            q = Q_MIN;
+        if (q > Q_MAX)
+            q = Q_MAX;
+        pluginData->f = f;
+        pluginData->fa = 1.0 - f;
+        pluginData->fb = q * (1.0 + (1.0 / pluginData->fa));
     }
+    buf = pluginData->buf;
+    f = pluginData->f;
+    fa = pluginData->fa;
+    fb = pluginData->fb;
+    for (l1 = 0; l1 < len; l1++)
+        output[l1] = gain * tickResLowpass(buf, input[l1], f, fa, fb, poles);
+    settleResLowpass(buf, poles);
+    pluginData->denormal_flushes += flushDenormals(buf, 4);
+    denormalsRestore(mode);
+}
+
+/*  The block is split at the parameter events as in runFiltType2(); with
+    count 0, for a bypassed instance, the events are only taken.
+*/
+static void runResLowpass(LV2_Handle instance, uint32_t sample_count)
+{
+    ResLowpass *pluginData = (ResLowpass *)instance;
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    float *ports[PARAM_COUNT] = {
+        pluginData->freq_ofs, pluginData->reso_ofs, NULL
+    };
+    float values[PARAM_COUNT], value;
+    uint32_t done = 0, at;
+    int poles = polesResLowpass(pluginData->poles);
+    int index;
+    paramBegin(&pluginData->params, ports, values);
+    do {
+        at = paramNext(&pluginData->params, count, &index, &value);
+        if (at > done) {
+            if (poles == 4)
+                runResLowpassSpan(pluginData, done, at - done, 4, values);
+            else
+                runResLowpassSpan(pluginData, done, at - done, 2, values);
+            done = at;
+        }
+        if (index >= 0)
+            paramSet(&pluginData->params, ports, values, index, value);
+    } while (index >= 0);
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initResLowpass()
@@ -111,6 +207,185 @@ static void cleanupResLowpassCV(LV2_Handle instance)
     free(instance);
 }
 
+/*  f and q for sample i of a CV block, as in the per-sample loops; conn
+    is the set of connected CV inputs and is expected to be a constant.
+*/
+static inline void coefsResLowpassCV(
+    double *f, double *q, double f0, double q0, float freq_ofs,
+    float freq_pitch, double rate_f, float *freq_in, float *reso_in,
+    uint32_t i, int conn)
+{
+    *f = ((conn & CV_FREQ) && (freq_in[i] > 0))
+        ? (freq_in[i] * (MAX_FREQ * 2.85) + (freq_ofs - MIN_FREQ))
+            / (double)MAX_FREQ * freq_pitch * rate_f
+        : f0 * freq_pitch;
+    if (*f < 0)
+        *f = 0;
+    if (*f > 0.99)
+        *f = 0.99;
+    if (conn & CV_RESO) {
+        *q = q0 + reso_in[i];
+        if (*q < 0)
+            *q = 0;
+        if (*q > 1)
+            *q = 1;
+    }
+    else {
+        *q = q0;
+        if (*q < Q_MIN)
+            *q = Q_MIN;
+        if (*q > Q_MAX)
+            *q = Q_MAX;
+    }
+}
+
+/*  len samples from offset on with the offsets freq_ofs and q0, see
+    runResLowpassCVPoles().  With mod_step above 1 f and q ramp to their
+    values at the end of every mod_step samples, also with no CV input
+    connected.  conn and poles are expected to be constants.
+*/
+static inline void spanResLowpassCV(
+    ResLowpassCV *pluginData, uint32_t offset, uint32_t len, int conn,
+    int poles, float freq_ofs, double q0, uint32_t mod_step)
+{
+    uint32_t l1, l2, step;
+    double f0, f, q, fa, fb, rate_f;
+    double f1, q1, f_step, q_step;
+    double *buf = pluginData->buf;
+    float *input = pluginData->input + offset;
+    float *output = pluginData->output + offset;
+    float gain = *(pluginData->gain);
+    float freq_pitch =
+        (*(pluginData->freq_pitch) > 0)
+            ? 1.0 + *(pluginData->freq_pitch) / 2.0
+            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
+    float *freq_in = (conn & CV_FREQ) ? pluginData->freq_in + offset : NULL;
+    float *reso_in = (conn & CV_RESO) ? pluginData->reso_in + offset : NULL;
+    rate_f = 44100.0 / pluginData->rate;
+    f0 = freq_ofs / (double)MAX_FREQ * rate_f * 2.85;
+    if (!conn && mod_step == 1) {
+        f = f0 * freq_pitch;
+        if (f < 0)
+            f = 0;
+        if (f > 0.9999)
+            f = 0.9999;
+        q = q0;
+        if (q < Q_MIN)
+            q = Q_MIN;
+        if (q > Q_MAX)
+            q = Q_MAX;
+        fa = 1.0 - f;
+        fb = q * (1.0 + (1.0 / fa));
+        for (l1 = 0; l1 < len; l1++)
+            output[l1] = gain
+                * tickResLowpass(buf, input[l1], f, fa, fb, poles);
+    }
+    else if (mod_step > 1) {
+        if (!pluginData->coefs_valid)
+            coefsResLowpassCV(&pluginData->coef_f, &pluginData->coef_q,
+                              f0, q0, freq_ofs, freq_pitch, rate_f,
+                              freq_in, reso_in, 0, conn);
+        pluginData->coefs_valid = 1;
+        f = pluginData->coef_f;
+        q = pluginData->coef_q;
+        for (l1 = 0; l1 < len; l1 += step) {
+            step = len - l1;
+            if (step > mod_step)
+                step = mod_step;
+            coefsResLowpassCV(&f1, &q1, f0, q0, freq_ofs, freq_pitch,
+                              rate_f, freq_in, reso_in, l1 + step - 1, conn);
+            f_step = (f1 - f) / step;
+            q_step = (q1 - q) / step;
+            for (l2 = l1; l2 < l1 + step; l2++) {
+                f += f_step;
+                q += q_step;
+                fa = 1.0 - f;
+                fb = q * (1.0 + (1.0 / fa));
+                output[l2] = gain
+                    * tickResLowpass(buf, input[l2], f, fa, fb, poles);
+            }
+            f = f1;
+            q = q1;
+        }
+        pluginData->coef_f = f;
+        pluginData->coef_q = q;
+    }
+    else {
+        for (l1 = 0; l1 < len; l1 += step) {
+            step = cvRunLength(conn, freq_in, reso_in, NULL, l1, len);
+            coefsResLowpassCV(&f, &q, f0, q0, freq_ofs, freq_pitch, rate_f,
+                              freq_in, reso_in, l1, conn);
+            fa = 1.0 - f;
+            fb = q * (1.0 + (1.0 / fa));
+            for (l2 = l1; l2 < l1 + step; l2++)
+                output[l2] = gain
+                    * tickResLowpass(buf, input[l2], f, fa, fb, poles);
+        }
+    }
+}
+
+/*  run() for one set of connected CV inputs and a number of poles.  With
+    a modulation source selected, see modsource.h, freq_ofs and reso_ofs
+    are moved every MOD_STEP samples and f and q ramp between the steps,
+    or follow the CVs as set by mod_rate where one is connected.
+*/
+static inline void runResLowpassCVPoles(
+    LV2_Handle instance, uint32_t sample_count, int conn, int poles)
+{
+    ResLowpassCV *pluginData = (ResLowpassCV *)instance;
+    modSource *mod = &pluginData->mod;
+    float freq_ofs = *(pluginData->freq_ofs);
+    double q0 = *(pluginData->reso_ofs);
+    double value;
+    uint32_t mod_step = (*(pluginData->mod_rate) > 1)
+        ? (uint32_t)*(pluginData->mod_rate) : 1;
+    uint32_t l1, len;
+    int modulated = modSourceBegin(mod);
+    if (mod_step > MOD_RATE_MAX)
+        mod_step = MOD_RATE_MAX;
+    if (runSilent(pluginData->input, pluginData->output, pluginData->buf,
+                  4, sample_count)) {
+        if (modulated)
+            modSourceIdle(mod, sample_count);
+        pluginData->coefs_valid = 0;
+        return;
+    }
+    if (!conn)
+        mod_step = modulated ? MOD_STEP : 1;
+    if (mod_step == 1)
+        pluginData->coefs_valid = 0;
+    if (modulated) {
+        for (l1 = 0; l1 < sample_count; l1 += len) {
+            len = sample_count - l1;
+            if (len > MOD_STEP)
+                len = MOD_STEP;
+            value = modSourceStep(mod, pluginData->input + l1, len);
+            spanResLowpassCV(pluginData, l1, len, conn, poles,
+                             freq_ofs * exp2(*(mod->freq_depth) * value),
+                             q0 + *(mod->reso_depth) * value, mod_step);
+        }
+    }
+    else {
+        spanResLowpassCV(pluginData, 0, sample_count, conn, poles, freq_ofs,
+                         q0, mod_step);
+    }
+    settleResLowpass(pluginData->buf, poles);
+    pluginData->denormal_flushes += flushDenormals(pluginData->buf, 4);
+}
+
+/* run() for one set of connected CV inputs, see CV_KERNELS */
+static inline void runResLowpassCVConn(
+    LV2_Handle instance, uint32_t sample_count, int conn)
+{
+    ResLowpassCV *pluginData = (ResLowpassCV *)instance;
+    if (polesResLowpass(pluginData->poles) == 4)
+        runResLowpassCVPoles(instance, sample_count, conn, 4);
+    else
+        runResLowpassCVPoles(instance, sample_count, conn, 2);
+}
+
+CV_KERNELS_NO_DBGAIN(ResLowpassCVKernels, runResLowpassCVConn)
+
 static void connectPortResLowpassCV(
     LV2_Handle instance, uint32_t port, void *data)
 {
@@ -124,6 +399,11 @@ static void connectPortResLowpassCV(
         case 5: plugin->freq_in = data;     break;
         case 6: plugin->reso_ofs = data;    break;
         case 7: plugin->reso_in = data;     break;
+        case 8: plugin->mod_rate = data;    break;
+        case 9: plugin->poles = data;       break;
+        case 10: plugin->bypass.enabled = data; break;
+        default: modSourceConnect(&plugin->mod, port - 11, data);
+                 break;
     }
 }
 
@@ -135,6 +415,12 @@ static LV2_Handle instantiateResLowpassCV(
 {
     ResLowpassCV* plugin_data = (ResLowpassCV*)malloc(sizeof(ResLowpassCV));
     plugin_data->rate = s_rate;
+    plugin_data->freq_in = NULL;
+    plugin_data->reso_in = NULL;
+    plugin_data->poles = NULL;
+    plugin_data->denormal_flushes = 0;
+    bypassInit(&plugin_data->bypass);
+    modSourceInit(&plugin_data->mod, s_rate, features);
     return (LV2_Handle)plugin_data;
 }
 
@@ -142,99 +428,24 @@ static void activateResLowpassCV(LV2_Handle instance)
 {
     ResLowpassCV *plugin_data = (ResLowpassCV *)instance;
     int l1;
-    for (l1 = 0; l1 < 2; l1++)
+    for (l1 = 0; l1 < 4; l1++)
       plugin_data->buf[l1] = 0;
+    plugin_data->coefs_valid = 0;
 }
 
 static void runResLowpassCV(LV2_Handle instance, uint32_t sample_count)
 {
-    uint32_t l1;
-    double f0, q0, f, q, fa, fb, rate, rate_f, k;
-    double *buf;
     ResLowpassCV *pluginData = (ResLowpassCV *)instance;
-    float *input = pluginData->input;
-    float *output = pluginData->output;
-    float gain = *(pluginData->gain);
-    float freq_ofs = *(pluginData->freq_ofs);
-    float freq_pitch =
-        (*(pluginData->freq_pitch) > 0)
-            ? 1.0 + *(pluginData->freq_pitch) / 2.0
-            : 1.0 / (1.0 - *(pluginData->freq_pitch) / 2.0);
-    float reso_ofs = *(pluginData->reso_ofs);
-    float *freq_in = pluginData->freq_in;
-    float *reso_in = pluginData->reso_in;
-    rate = pluginData->rate;
-    rate_f = 44100.0 / rate;
-    buf = pluginData->buf;
-    f0 = freq_ofs / (double)MAX_FREQ * rate_f * 2.85;;
-    q0 = reso_ofs;
-    if (!(freq_in || reso_in)) {
-        f = f0 * freq_pitch;
-        if (f < 0)
-            f = 0;
-        if (f > 0.9999)
-            f = 0.9999;
-        q = q0;
-        if (q < Q_MIN)
-            q = Q_MIN;
-        if (q > Q_MAX)
-            q = Q_MAX;
-        fa = 1.0 - f;
-        fb = q * (1.0 + (1.0 / fa));
-        for (l1 = 0; l1 < sample_count; l1++) {
-            buf[0] = fa * buf[0] + f * (input[l1] + fb * (buf[0] - buf[1]));
-            buf[1] = fa * buf[1] + f * buf[0];
-            output[l1] = gain * buf[1];
-        }
-    }
-    else {
-        if (!reso_in) {
-            q = q0;
-            if (q < Q_MIN)
-                q = Q_MIN;
-            if (q > Q_MAX)
-                q = Q_MAX;
-            k =  MAX_FREQ * 2.85;
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in[l1] > 0)
-                    ? (freq_in[l1] * k + (freq_ofs - MIN_FREQ))
-                        / (double)MAX_FREQ * freq_pitch * rate_f
-                    : f0 * freq_pitch;
-                if (f < 0)
-                    f = 0;
-                if (f > 0.99)
-                    f = 0.99;
-                fa = 1.0 - f;
-                fb = q * (1.0 + (1.0 / fa));
-                buf[0] = fa * buf[0] + f * (input[l1] + fb * (buf[0] - buf[1])); 
-                buf[1] = fa * buf[1] + f * buf[0];
-                output[l1] = gain * buf[1];
-            }
-        }
-        else {
-            k = MAX_FREQ * 2.85;
-            for (l1 = 0; l1 < sample_count; l1++) {
-                f = (freq_in && (freq_in[l1] > 0))
-                    ? (freq_in[l1] * k + (freq_ofs - MIN_FREQ))
-                        / (double)MAX_FREQ * freq_pitch * rate_f
-                    : f0 * freq_pitch;
-                if (f < 0)
-                    f = 0;
-                if (f > 0.99)
-                    f = 0.99;
-                q = q0 + reso_in[l1];
-                if (q < 0)
-                    q = 0;
-                if (q > 1)
-                    q = 1;
-                fa = 1.0 - f;
-                fb = q * (1.0 + (1.0 / fa));
-                buf[0] = fa * buf[0] + f * (input[l1] + fb * (buf[0] - buf[1]));
-                buf[1] = fa * buf[1] + f * buf[0];
-                output[l1] = gain * buf[1];
-            }
-        }
+    uint32_t count = bypassBegin(&pluginData->bypass, pluginData->input,
+                                 pluginData->output, sample_count);
+    int conn;
+    if (count) {
+        conn = cvActiveConnections(pluginData->freq_in, pluginData->reso_in,
+                                   NULL, count);
+        ResLowpassCVKernels[conn](instance, count);
     }
+    bypassEnd(&pluginData->bypass, pluginData->input, pluginData->output,
+              sample_count);
 }
 
 static void initResLowpassCV()
@@ -251,6 +462,215 @@ static void initResLowpassCV()
     ResLowpassCVDescriptor->extension_data =   NULL;
 }
 
+static LV2_Handle instantiateResLowpassVoices(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    ResLowpassVoices *plugin_data;
+    uint32_t voices =
+        voicesOfDescriptor(descriptor, ResLowpassVoicesDescriptor);
+    if (!voices)
+        return NULL;
+    plugin_data = (ResLowpassVoices *)calloc(1, sizeof(ResLowpassVoices));
+    if (!plugin_data)
+        return NULL;
+    plugin_data->ports.voices = voices;
+    plugin_data->ports.rate = s_rate;
+    return (LV2_Handle)plugin_data;
+}
+
+static void cleanupResLowpassVoices(LV2_Handle instance)
+{
+    free(instance);
+}
+
+static void connectPortResLowpassVoices(
+    LV2_Handle instance, uint32_t port, void *data)
+{
+    connectPortVoices(&((ResLowpassVoices *)instance)->ports, port, data);
+}
+
+static void activateResLowpassVoices(LV2_Handle instance)
+{
+    ResLowpassVoices *plugin_data = (ResLowpassVoices *)instance;
+    int l1;
+    for (l1 = 0; l1 < VOICES_MAX; l1++)
+      plugin_data->buf0[l1] = plugin_data->buf1[l1] = 0;
+    plugin_data->coefs_valid = 0;
+}
+
+/*  f and q of every voice from one sample of the CVs, as
+    coefsResLowpassCV() computes them for a _cv instance.
+*/
+static inline void coefsResLowpassVoices(
+    ResLowpassVoices *pluginData, double *f, double *q, const double *freq,
+    const double *reso, double f0, double q0, float freq_ofs,
+    float freq_pitch, double rate_f)
+{
+    uint32_t voices = pluginData->ports.voices;
+    uint32_t l1;
+    for (l1 = 0; l1 < voices; l1++) {
+        f[l1] = (freq[l1] > 0)
+            ? (freq[l1] * MAX_FREQ * 2.85 + (freq_ofs - MIN_FREQ))
+                / (double)MAX_FREQ * freq_pitch * rate_f
+            : f0 * freq_pitch;
+        f[l1] = (f[l1] < 0) ? 0 : f[l1];
+        f[l1] = (f[l1] > 0.99) ? 0.99 : f[l1];
+        q[l1] = q0 + reso[l1];
+        q[l1] = (q[l1] < pluginData->q_min[l1]) ? pluginData->q_min[l1] : q[l1];
+        q[l1] = (q[l1] > pluginData->q_max[l1]) ? pluginData->q_max[l1] : q[l1];
+    }
+}
+
+/* Decimated f1 and q1 of every voice for sample i */
+static inline void targetResLowpassVoices(
+    ResLowpassVoices *pluginData, double f0, double q0, float freq_ofs,
+    float freq_pitch, double rate_f, uint32_t i)
+{
+    filtVoicePorts *ports = &pluginData->ports;
+    double freq[VOICES_MAX], reso[VOICES_MAX];
+    loadCVVoices(freq, ports->freq_in, ports->voices, i);
+    loadCVVoices(reso, ports->reso_in, ports->voices, i);
+    coefsResLowpassVoices(pluginData, pluginData->f1, pluginData->q1,
+                          freq, reso, f0, q0, freq_ofs, freq_pitch, rate_f);
+}
+
+/* Run the recursion over the first len rows of the tile */
+static inline void runTileResLowpassVoices(
+    ResLowpassVoices *pluginData, double gain, uint32_t len)
+{
+    uint32_t voices = pluginData->ports.voices;
+    uint32_t l1, l2;
+    double f, fa, fb;
+    for (l1 = 0; l1 < len; l1++) {
+        for (l2 = 0; l2 < voices; l2++) {
+            f = pluginData->f_tile[l1][l2];
+            fa = 1.0 - f;
+            fb = pluginData->q_tile[l1][l2] * (1.0 + (1.0 / fa));
+            pluginData->buf0[l2] = fa * pluginData->buf0[l2]
+                + f * (pluginData->in[l1][l2]
+                       + fb * (pluginData->buf0[l2] - pluginData->buf1[l2]));
+            pluginData->buf1[l2] = fa * pluginData->buf1[l2]
+                + f * pluginData->buf0[l2];
+            pluginData->out[l1][l2] = gain * pluginData->buf1[l2];
+        }
+    }
+}
+
+static VCF_SIMD void runResLowpassVoices(
+    LV2_Handle instance, uint32_t sample_count)
+{
+    uint32_t l1, l2, l3, len, seg_end = 0;
+    double f0, q0, rate_f, inv_len;
+    ResLowpassVoices *pluginData = (ResLowpassVoices *)instance;
+    filtVoicePorts *ports = &pluginData->ports;
+    uint32_t voices = ports->voices;
+    uint32_t mod_step = modStepVoices(ports);
+    float gain = *(ports->gain);
+    float freq_ofs = *(ports->freq_ofs);
+    float freq_pitch =
+        (*(ports->freq_pitch) > 0)
+            ? 1.0 + *(ports->freq_pitch) / 2.0
+            : 1.0 / (1.0 - *(ports->freq_pitch) / 2.0);
+    fpuMode mode;
+    if (inputsZeroVoices(ports->input, voices, sample_count)
+        && stateDecayed(pluginData->buf0, voices)
+        && stateDecayed(pluginData->buf1, voices)) {
+        memset(pluginData->buf0, 0, voices * sizeof(double));
+        memset(pluginData->buf1, 0, voices * sizeof(double));
+        zeroOutputsVoices(ports->output, voices, sample_count);
+        pluginData->coefs_valid = 0;
+        return;
+    }
+    mode = denormalsOff();
+    rate_f = 44100.0 / ports->rate;
+    f0 = freq_ofs / (double)MAX_FREQ * rate_f * 2.85;
+    q0 = *(ports->reso_ofs);
+    for (l1 = 0; l1 < voices; l1++) {
+        pluginData->q_min[l1] = (ports->reso_in[l1]) ? 0 : Q_MIN;
+        pluginData->q_max[l1] = (ports->reso_in[l1]) ? 1 : Q_MAX;
+    }
+    if (mod_step == 1)
+        pluginData->coefs_valid = 0;
+    for (l1 = 0; l1 < sample_count; l1 += len) {
+        len = sample_count - l1;
+        if (len > VOICES_TILE)
+            len = VOICES_TILE;
+        loadTileVoices(pluginData->in, ports->input, voices, l1, len);
+        if (mod_step == 1) {
+            loadTileVoices(pluginData->freq, ports->freq_in, voices, l1, len);
+            loadTileVoices(pluginData->reso, ports->reso_in, voices, l1, len);
+            for (l2 = 0; l2 < len; l2++)
+                coefsResLowpassVoices(pluginData, pluginData->f_tile[l2],
+                                      pluginData->q_tile[l2],
+                                      pluginData->freq[l2],
+                                      pluginData->reso[l2], f0, q0,
+                                      freq_ofs, freq_pitch, rate_f);
+        }
+        else {
+            for (l2 = 0; l2 < len; l2++) {
+                if (l1 + l2 == seg_end) {
+                    seg_end = l1 + l2 + mod_step;
+                    if (seg_end > sample_count)
+                        seg_end = sample_count;
+                    if (!pluginData->coefs_valid) {
+                        targetResLowpassVoices(pluginData, f0, q0, freq_ofs,
+                                               freq_pitch, rate_f, l1 + l2);
+                        for (l3 = 0; l3 < voices; l3++) {
+                            pluginData->f[l3] = pluginData->f1[l3];
+                            pluginData->q[l3] = pluginData->q1[l3];
+                        }
+                        pluginData->coefs_valid = 1;
+                    }
+                    targetResLowpassVoices(pluginData, f0, q0, freq_ofs,
+                                           freq_pitch, rate_f, seg_end - 1);
+                    inv_len = 1.0 / (seg_end - l1 - l2);
+                    for (l3 = 0; l3 < voices; l3++) {
+                        pluginData->f_step[l3] =
+                            (pluginData->f1[l3] - pluginData->f[l3]) * inv_len;
+                        pluginData->q_step[l3] =
+                            (pluginData->q1[l3] - pluginData->q[l3]) * inv_len;
+                    }
+                }
+                for (l3 = 0; l3 < voices; l3++) {
+                    pluginData->f_tile[l2][l3] =
+                        pluginData->f[l3] += pluginData->f_step[l3];
+                    pluginData->q_tile[l2][l3] =
+                        pluginData->q[l3] += pluginData->q_step[l3];
+                }
+                if (l1 + l2 + 1 == seg_end) {
+                    for (l3 = 0; l3 < voices; l3++) {
+                        pluginData->f[l3] = pluginData->f1[l3];
+                        pluginData->q[l3] = pluginData->q1[l3];
+                    }
+                }
+            }
+        }
+        runTileResLowpassVoices(pluginData, gain, len);
+        storeTileVoices(ports->output, pluginData->out, voices, l1, len);
+    }
+    pluginData->denormal_flushes +=
+        flushDenormals(pluginData->buf0, voices)
+        | flushDenormals(pluginData->buf1, voices);
+    denormalsRestore(mode);
+}
+
+static void initResLowpassVoices(int index)
+{
+    ResLowpassVoicesDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    ResLowpassVoicesDescriptor[index]->URI =              ResLowpassVoicesURI[index];
+    ResLowpassVoicesDescriptor[index]->activate =         activateResLowpassVoices;
+    ResLowpassVoicesDescriptor[index]->cleanup =          cleanupResLowpassVoices;
+    ResLowpassVoicesDescriptor[index]->connect_port =     connectPortResLowpassVoices;
+    ResLowpassVoicesDescriptor[index]->deactivate =       NULL;
+    ResLowpassVoicesDescriptor[index]->instantiate =      instantiateResLowpassVoices;
+    ResLowpassVoicesDescriptor[index]->run =              runResLowpassVoices;
+    ResLowpassVoicesDescriptor[index]->extension_data =   NULL;
+}
+
 LV2_SYMBOL_EXPORT
 const LV2_Descriptor *lv2_descriptor(uint32_t index)
 {
@@ -263,6 +683,12 @@ const LV2_Descriptor *lv2_descriptor(uint32_t index)
             if (!ResLowpassCVDescriptor)
                 initResLowpassCV();
             return ResLowpassCVDescriptor;
+        case 2:
+        case 3:
+        case 4:
+            if (!ResLowpassVoicesDescriptor[index - 2])
+                initResLowpassVoices(index - 2);
+            return ResLowpassVoicesDescriptor[index - 2];
     }
     return NULL;
 }
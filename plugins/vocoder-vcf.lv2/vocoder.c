@@ -0,0 +1,56 @@
+/******************* Vocoder, Formula by Robert Bristow-Johnson ********************/
+/*  Channel vocoder from two banks of bandpass2 filters, see
+    filter_vocoder.h
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include <lv2.h>
+
+#include "vcf.h"
+#include "filter_vocoder.h"
+
+static LV2_Descriptor *VocoderDescriptor[VOCODER_DESCRIPTORS];
+
+static const char *VocoderURI[VOCODER_DESCRIPTORS] = {
+    "http://jwm-art.net/lv2/vcf/vocoder_16",
+    "http://jwm-art.net/lv2/vcf/vocoder_32"
+};
+
+static LV2_Handle instantiateVocoder(
+    const LV2_Descriptor *descriptor,
+    double s_rate,
+    const char *path,
+    const LV2_Feature * const* features)
+{
+    return instantiateFiltVocoder(descriptor, s_rate, VocoderDescriptor);
+}
+
+static VCF_SIMD void runVocoder(LV2_Handle instance, uint32_t sample_count)
+{
+    runFiltVocoder((filtVocoder *)instance, sample_count);
+}
+
+static void initVocoder(int index)
+{
+    VocoderDescriptor[index] =
+        (LV2_Descriptor *) malloc(sizeof(LV2_Descriptor));
+    VocoderDescriptor[index]->URI =              VocoderURI[index];
+    VocoderDescriptor[index]->activate =         activateFiltVocoder;
+    VocoderDescriptor[index]->cleanup =          cleanupFiltVocoder;
+    VocoderDescriptor[index]->connect_port =     connectPortFiltVocoder;
+    VocoderDescriptor[index]->deactivate =       NULL;
+    VocoderDescriptor[index]->instantiate =      instantiateVocoder;
+    VocoderDescriptor[index]->run =              runVocoder;
+    VocoderDescriptor[index]->extension_data =   NULL;
+}
+
+LV2_SYMBOL_EXPORT
+const LV2_Descriptor *lv2_descriptor(uint32_t index)
+{
+    if (index >= VOCODER_DESCRIPTORS)
+        return NULL;
+    if (!VocoderDescriptor[index])
+        initVocoder(index);
+    return VocoderDescriptor[index];
+}
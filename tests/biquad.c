@@ -0,0 +1,139 @@
+/*  Accuracy check of the block kernel against the sample loop.
+
+    biquad
+        For random RBJ designs of every type, among them cutoffs near
+        Nyquist, very low cutoffs and high Q, a noise signal is run
+        through biquadRun(), which takes biquadRunBlock() from
+        BIQUAD_BLOCK_MIN samples on, and through a plain biquadTick()
+        loop.  The signal is split into calls of lengths on both sides of
+        BIQUAD_BLOCK_MIN and off multiples of BIQUAD_BLOCK, so the state
+        is handed on between calls and between the two paths.
+
+        The sample loop rounds each output to float before it goes back
+        into the recursion, which near 1 Hz or at high Q leaves it 1e-3 of
+        the peak away from the exact filter, so the two paths are both
+        measured against the same recursion in double.  Exits nonzero if
+        the error of biquadRun() is more than BIQUAD_CHECK_TOLERANCE of the
+        peak of the output plus BIQUAD_CHECK_RATIO times that of
+        biquadTick(): where the sample loop is exact to float the block
+        kernel must be within BIQUAD_CHECK_TOLERANCE too, and where the
+        filter itself is badly conditioned it may not be much worse.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "biquad.h"
+
+#define RATE                    48000.0
+#define SIGNAL                   4096
+#define DESIGNS                  1000
+#define BIQUAD_CHECK_TOLERANCE   1e-6
+#define BIQUAD_CHECK_RATIO        6.0
+
+static const uint32_t lengths[] = {
+  1, 7, 8, 31, 32, 33, 40, 63, 64, 67, 129, 256, 1001
+};
+
+#define LENGTHS (sizeof(lengths) / sizeof(lengths[0]))
+
+static const char *type_name[] = {
+  "lowpass", "highpass", "bandpass1", "bandpass2", "notch", "peak_eq",
+  "low_shelf", "high_shelf"
+};
+
+static double uniform(double lo, double hi)
+{
+  return lo + (hi - lo) * (rand() / (double)RAND_MAX);
+}
+
+/*  Design d of DESIGNS: the first ones on the edges, near Nyquist, at
+    1 Hz and at high Q, the rest random with log distributed freq and Q.
+*/
+static void design(int d, int *type, double *freq, double *q, double *dBgain)
+{
+  static const double edge_freq[] = { 0.49 * RATE, 0.45 * RATE, 1.0, 5.0 };
+  static const double edge_q[] = { 0.5, 0.7071, 20.0, 50.0 };
+  *type = d % 8;
+  *dBgain = uniform(-24.0, 24.0);
+  if (d < 8 * 4 * 4) {
+    *freq = edge_freq[d / 8 % 4];
+    *q = edge_q[d / 32 % 4];
+    return;
+  }
+  *freq = exp(uniform(log(1.0), log(0.49 * RATE)));
+  *q = exp(uniform(log(0.5), log(50.0)));
+}
+
+/*  Largest differences, over the peak of the output, of biquadRun()
+    and of the biquadTick() loop from the recursion in double, in err[0]
+    and err[1], and of the two from each other in err[2].
+*/
+static void check(const biquadCoefs *c, const float *input, uint32_t first,
+    double *err)
+{
+  static float block[SIGNAL], tick[SIGNAL];
+  static double exact[SIGNAL];
+  double buf_block[4] = { 0, 0, 0, 0 }, buf_tick[4] = { 0, 0, 0, 0 };
+  double x1 = 0, x2 = 0, y1 = 0, y2 = 0, peak = 0, d[3];
+  uint32_t done, len, l1, l2, n = first;
+  for (done = 0; done < SIGNAL; done += len) {
+    len = lengths[n++ % LENGTHS];
+    if (len > SIGNAL - done)
+      len = SIGNAL - done;
+    biquadRun(c, buf_block, input + done, block + done, len);
+  }
+  for (l1 = 0; l1 < SIGNAL; l1++) {
+    tick[l1] = biquadTick(c, buf_tick, input[l1]);
+    exact[l1] = c->b0 * input[l1] + c->b1 * x1 + c->b2 * x2
+        - c->a1 * y1 - c->a2 * y2;
+    x2 = x1;
+    x1 = input[l1];
+    y2 = y1;
+    y1 = exact[l1];
+    peak = (fabs(exact[l1]) > peak) ? fabs(exact[l1]) : peak;
+  }
+  err[0] = err[1] = err[2] = 0;
+  for (l1 = 0; l1 < SIGNAL; l1++) {
+    d[0] = fabs(block[l1] - exact[l1]);
+    d[1] = fabs(tick[l1] - exact[l1]);
+    d[2] = fabs((double)block[l1] - tick[l1]);
+    for (l2 = 0; l2 < 3; l2++)
+      err[l2] = (d[l2] > err[l2] || isnan(d[l2])) ? d[l2] : err[l2];
+  }
+  for (l2 = 0; l2 < 3; l2++)
+    err[l2] /= (peak > 1e-30) ? peak : 1e-30;
+}
+
+int main(void)
+{
+  static float input[SIGNAL];
+  biquadCoefs c;
+  double freq, q, dBgain, pi2_f, err[3], worst[3] = { 0, 0, 0 };
+  int d, l1, type, failed = 0;
+  srand(1);
+  for (d = 0; d < SIGNAL; d++)
+    input[d] = rand() / (float)RAND_MAX - 0.5f;
+  for (d = 0; d < DESIGNS; d++) {
+    design(d, &type, &freq, &q, &dBgain);
+    pi2_f = 2.0 * M_PI / RATE * freq;
+    rbjCoefs(&c, type, sin(pi2_f), cos(pi2_f), q * (2.0 / Q_SCALE),
+             exp(dBgain / 40.0 * log(10.0)), 1.0);
+    check(&c, input, (uint32_t)d, err);
+    if (!(err[0] <= BIQUAD_CHECK_TOLERANCE
+               + BIQUAD_CHECK_RATIO * err[1])) {
+      printf("FAIL %s freq %g q %g dBgain %g: error %g, sample loop %g\n",
+             type_name[type], freq, q, dBgain, err[0], err[1]);
+      failed++;
+    }
+    for (l1 = 0; l1 < 3; l1++)
+      worst[l1] = (err[l1] > worst[l1]) ? err[l1] : worst[l1];
+  }
+  printf("biquad: %d designs, worst error of the peak %g block, %g sample "
+         "loop, %g between them\n", DESIGNS, worst[0], worst[1], worst[2]);
+  if (failed)
+    printf("%d failed\n", failed);
+  return failed != 0;
+}
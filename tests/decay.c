@@ -0,0 +1,489 @@
+/*  Decay checks and the idle load benchmark for the plugin bundles.
+
+    decay BUNDLE...
+        Every descriptor of every bundle, with its controls at their
+        lv2:default, is fed a window of noise on its audio inputs, then an
+        impulse and then silence for DECAY_SECONDS.  The time of each
+        run() is taken; no window of the tail may cost more than
+        DECAY_RATIO times the noise, as a filter state left to decay into
+        subnormals would on x86.  Exits nonzero if a descriptor fails or
+        puts out a non-finite sample.
+
+    decay -s N BUNDLE...
+        Mostly silent tracks: N instances of every descriptor, each with
+        input on one block in SILENT_PERIOD and zeros otherwise, against
+        the same N instances with input on every block.  Prints the time
+        of one block of all N instances for both.
+
+    The ports are read from the .ttl files of the bundle, see ttlRead():
+    the parser knows the layout of this repository's files only.  Every
+    port is connected, the CV inputs to zeros and the atom inputs to an
+    empty sequence.
+*/
+
+#include <dirent.h>
+#include <dlfcn.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <lv2.h>
+#include <lv2/lv2plug.in/ns/ext/atom/atom.h>
+#include <lv2/lv2plug.in/ns/ext/urid/urid.h>
+
+#define VCF_URI         "http://jwm-art.net/lv2/vcf/"
+#define RATE            48000.0
+#define BLOCK           256
+#define DECAY_SECONDS   8
+#define DECAY_WINDOW    50
+#define DECAY_RATIO     4.0
+/* ns a block below which timings are noise */
+#define DECAY_FLOOR     2000.0
+#define SILENT_SECONDS  1
+#define SILENT_PERIOD   50
+#define PORTS_MAX       256
+#define PLUGINS_MAX     64
+#define URIDS_MAX       64
+
+enum {
+  PORT_NONE,
+  PORT_AUDIO_IN,
+  PORT_AUDIO_OUT,
+  PORT_CV_IN,
+  PORT_CONTROL_IN,
+  PORT_CONTROL_OUT,
+  PORT_ATOM_IN
+};
+
+typedef struct {
+  char name[128];
+  uint32_t ports;
+  int type[PORTS_MAX];
+  float value[PORTS_MAX];
+} ttlPlugin;
+
+typedef struct {
+  ttlPlugin plugin[PLUGINS_MAX];
+  int plugins;
+} ttlBundle;
+
+static char *urids[URIDS_MAX];
+static int urid_count;
+
+static LV2_URID mapURI(LV2_URID_Map_Handle handle, const char *uri)
+{
+  int l1;
+  (void)handle;
+  for (l1 = 0; l1 < urid_count; l1++)
+    if (!strcmp(urids[l1], uri))
+      return l1 + 1;
+  if (urid_count == URIDS_MAX)
+    return 0;
+  urids[urid_count] = strdup(uri);
+  return ++urid_count;
+}
+
+static LV2_URID_Map urid_map = { NULL, mapURI };
+static const LV2_Feature map_feature = { LV2_URID__map, &urid_map };
+static const LV2_Feature *features[] = { &map_feature, NULL };
+
+static float zeros[BLOCK];
+static float impulse[BLOCK] = { 1.0f };
+static float noise[BLOCK];
+static LV2_Atom_Sequence empty_sequence;
+
+static double now(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*  Next token of a .ttl file into token: a quoted string is skipped
+    whole, '[', ']' and ';' stand alone.  Zero at the end of the file.
+*/
+static int ttlToken(FILE *file, char *token, size_t size)
+{
+  size_t len = 0;
+  int c;
+  while ((c = fgetc(file)) != EOF) {
+    if (c == '"') {
+      while ((c = fgetc(file)) != EOF && c != '"')
+        ;
+      strcpy(token, "\"\"");
+      return 1;
+    }
+    if (c == '#' && !len) {
+      while ((c = fgetc(file)) != EOF && c != '\n')
+        ;
+      continue;
+    }
+    if (c == '[' || c == ']' || c == ';') {
+      if (len) {
+        ungetc(c, file);
+        break;
+      }
+      token[0] = c;
+      token[1] = 0;
+      return 1;
+    }
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+      if (len)
+        break;
+      continue;
+    }
+    if (len + 1 < size)
+      token[len++] = c;
+  }
+  token[len] = 0;
+  return len > 0;
+}
+
+/*  Add the plugins of one .ttl file, with the type of each port and the
+    lv2:default of the control inputs.
+*/
+static void ttlRead(ttlBundle *bundle, const char *path)
+{
+  FILE *file = fopen(path, "r");
+  char token[256], last[256] = "", subject[256] = "";
+  ttlPlugin *plugin = NULL;
+  int depth = 0, port_depth = -1, in_type = 0, want = 0;
+  int audio = 0, cv = 0, control = 0, atom = 0, output = 0;
+  long index = -1;
+  double value = 0;
+  if (!file)
+    return;
+  while (ttlToken(file, token, sizeof(token))) {
+    if (!depth && !strncmp(last, "vcf:", 4) && !strcmp(token, "a"))
+      strcpy(subject, last + 4);
+    else if (subject[0] && strstr(token, "lv2:Plugin")) {
+      if (bundle->plugins == PLUGINS_MAX)
+        break;
+      plugin = &bundle->plugin[bundle->plugins++];
+      memset(plugin, 0, sizeof(ttlPlugin));
+      strcpy(plugin->name, subject);
+      subject[0] = 0;
+    }
+    else if (!strcmp(token, "[")) {
+      if (plugin && !strcmp(last, "lv2:port") && port_depth < 0) {
+        port_depth = depth;
+        audio = cv = control = atom = output = 0;
+        index = -1;
+        value = 0;
+      }
+      depth++;
+    }
+    else if (!strcmp(token, "]")) {
+      depth--;
+      if (depth == port_depth) {
+        port_depth = -1;
+        if (index >= 0 && index < PORTS_MAX) {
+          plugin->type[index] =
+              audio ? (output ? PORT_AUDIO_OUT : PORT_AUDIO_IN)
+              : cv ? PORT_CV_IN
+              : control ? (output ? PORT_CONTROL_OUT : PORT_CONTROL_IN)
+              : atom ? PORT_ATOM_IN : PORT_NONE;
+          plugin->value[index] = value;
+          if ((uint32_t)index + 1 > plugin->ports)
+            plugin->ports = index + 1;
+        }
+      }
+    }
+    else if (port_depth >= 0 && depth == port_depth + 1) {
+      if (!strcmp(token, ";"))
+        in_type = 0;
+      else if (!strcmp(last, "a") && !want)
+        in_type = 1;
+      if (in_type) {
+        audio |= (strstr(token, "AudioPort") != NULL);
+        cv |= (strstr(token, "CVPort") != NULL);
+        control |= (strstr(token, "ControlPort") != NULL);
+        atom |= (strstr(token, "AtomPort") != NULL);
+        output |= (strstr(token, "OutputPort") != NULL);
+      }
+      if (want == 1)
+        index = strtol(token, NULL, 10);
+      else if (want == 2)
+        value = strtod(token, NULL);
+      want = !strcmp(token, "lv2:index") ? 1
+          : !strcmp(token, "lv2:default") ? 2 : 0;
+    }
+    strcpy(last, token);
+  }
+  fclose(file);
+}
+
+static void bundleRead(ttlBundle *bundle, const char *dir)
+{
+  DIR *d = opendir(dir);
+  struct dirent *entry;
+  char path[1024];
+  size_t len;
+  bundle->plugins = 0;
+  if (!d)
+    return;
+  while ((entry = readdir(d))) {
+    len = strlen(entry->d_name);
+    if (len < 4 || strcmp(entry->d_name + len - 4, ".ttl")
+        || !strcmp(entry->d_name, "manifest.ttl"))
+      continue;
+    snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+    ttlRead(bundle, path);
+  }
+  closedir(d);
+}
+
+static const ttlPlugin *bundleFind(const ttlBundle *bundle, const char *uri)
+{
+  int l1;
+  if (strncmp(uri, VCF_URI, strlen(VCF_URI)))
+    return NULL;
+  for (l1 = 0; l1 < bundle->plugins; l1++)
+    if (!strcmp(bundle->plugin[l1].name, uri + strlen(VCF_URI)))
+      return &bundle->plugin[l1];
+  return NULL;
+}
+
+/*  An instance with every port connected, the outputs to buffers of
+    their own in out and controls.
+*/
+typedef struct {
+  const LV2_Descriptor *descriptor;
+  const ttlPlugin *plugin;
+  LV2_Handle handle;
+  float controls[PORTS_MAX];
+  float *out[PORTS_MAX];
+} instance;
+
+static int instanceNew(instance *inst, const LV2_Descriptor *descriptor,
+    const ttlPlugin *plugin)
+{
+  uint32_t l1;
+  memset(inst, 0, sizeof(instance));
+  inst->descriptor = descriptor;
+  inst->plugin = plugin;
+  inst->handle = descriptor->instantiate(descriptor, RATE, "", features);
+  if (!inst->handle)
+    return 0;
+  for (l1 = 0; l1 < plugin->ports; l1++) {
+    switch (plugin->type[l1]) {
+    case PORT_AUDIO_IN:
+      descriptor->connect_port(inst->handle, l1, zeros);
+      break;
+    case PORT_CV_IN:
+      descriptor->connect_port(inst->handle, l1, zeros);
+      break;
+    case PORT_AUDIO_OUT:
+      inst->out[l1] = (float *)calloc(BLOCK, sizeof(float));
+      descriptor->connect_port(inst->handle, l1, inst->out[l1]);
+      break;
+    case PORT_CONTROL_IN:
+    case PORT_CONTROL_OUT:
+      inst->controls[l1] = plugin->value[l1];
+      descriptor->connect_port(inst->handle, l1, &inst->controls[l1]);
+      break;
+    case PORT_ATOM_IN:
+      descriptor->connect_port(inst->handle, l1, &empty_sequence);
+      break;
+    }
+  }
+  if (descriptor->activate)
+    descriptor->activate(inst->handle);
+  return 1;
+}
+
+static void instanceFree(instance *inst)
+{
+  uint32_t l1;
+  if (inst->handle) {
+    if (inst->descriptor->deactivate)
+      inst->descriptor->deactivate(inst->handle);
+    inst->descriptor->cleanup(inst->handle);
+  }
+  for (l1 = 0; l1 < PORTS_MAX; l1++)
+    free(inst->out[l1]);
+}
+
+/* Connect every audio input to input */
+static void instanceInput(instance *inst, float *input)
+{
+  uint32_t l1;
+  for (l1 = 0; l1 < inst->plugin->ports; l1++)
+    if (inst->plugin->type[l1] == PORT_AUDIO_IN)
+      inst->descriptor->connect_port(inst->handle, l1, input);
+}
+
+/* Nonzero if every output sample of the last block is finite */
+static int instanceFinite(const instance *inst)
+{
+  uint32_t l1, l2;
+  for (l1 = 0; l1 < inst->plugin->ports; l1++)
+    for (l2 = 0; inst->out[l1] && l2 < BLOCK; l2++)
+      if (!isfinite(inst->out[l1][l2]))
+        return 0;
+  return 1;
+}
+
+static int compareDouble(const void *a, const void *b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+static double median(const double *values, int count)
+{
+  double sorted[DECAY_WINDOW];
+  memcpy(sorted, values, count * sizeof(double));
+  qsort(sorted, count, sizeof(double), compareDouble);
+  return sorted[count / 2];
+}
+
+/*  Noise, then the impulse and its tail through one instance; the
+    median time of a block over the noise and over the worst window of
+    the tail.  Nonzero if it passed.
+*/
+static int decayCheck(const LV2_Descriptor *descriptor,
+    const ttlPlugin *plugin)
+{
+  const int blocks = DECAY_SECONDS * (int)RATE / BLOCK;
+  double times[DECAY_WINDOW], t, busy = 0, tail = 0, m;
+  instance inst;
+  int block, finite = 1;
+  if (!instanceNew(&inst, descriptor, plugin)) {
+    printf("FAIL %-28s instantiate\n", plugin->name);
+    return 0;
+  }
+  for (block = 0; block < DECAY_WINDOW + blocks; block++) {
+    instanceInput(&inst, (block < DECAY_WINDOW) ? noise
+                  : (block == DECAY_WINDOW) ? impulse : zeros);
+    t = now();
+    descriptor->run(inst.handle, BLOCK);
+    times[block % DECAY_WINDOW] = now() - t;
+    finite &= instanceFinite(&inst);
+    if (block % DECAY_WINDOW == DECAY_WINDOW - 1) {
+      m = median(times, DECAY_WINDOW);
+      if (block < DECAY_WINDOW)
+        busy = m;
+      else if (m > tail)
+        tail = m;
+    }
+  }
+  instanceFree(&inst);
+  if (!finite || tail > DECAY_RATIO * busy + DECAY_FLOOR) {
+    printf("FAIL %-28s busy %8.0f ns/block  tail %8.0f ns/block%s\n",
+           plugin->name, busy, tail, finite ? "" : "  non-finite output");
+    return 0;
+  }
+  printf("ok   %-28s busy %8.0f ns/block  tail %8.0f ns/block\n",
+         plugin->name, busy, tail);
+  return 1;
+}
+
+/*  Time of one block of count instances, each with input on one block in
+    period, the blocks of the instances spread evenly.
+*/
+static double silentRun(instance *insts, int count, int period)
+{
+  const int blocks = SILENT_SECONDS * (int)RATE / BLOCK;
+  double t;
+  int block, l1;
+  t = now();
+  for (block = 0; block < blocks; block++) {
+    for (l1 = 0; l1 < count; l1++) {
+      instanceInput(&insts[l1],
+                    ((block + l1 * period / count) % period) ? zeros : noise);
+      insts[l1].descriptor->run(insts[l1].handle, BLOCK);
+    }
+  }
+  return (now() - t) / blocks;
+}
+
+static int silentBench(const LV2_Descriptor *descriptor,
+    const ttlPlugin *plugin, int count)
+{
+  instance *insts = (instance *)calloc(count, sizeof(instance));
+  double silent, busy;
+  int l1, ok = 1;
+  if (!insts)
+    return 0;
+  for (l1 = 0; l1 < count; l1++)
+    ok &= instanceNew(&insts[l1], descriptor, plugin);
+  if (ok) {
+    busy = silentRun(insts, count, 1);
+    silent = silentRun(insts, count, SILENT_PERIOD);
+    printf("%-28s %3d tracks  silent %9.0f ns/block  busy %9.0f ns/block"
+           "  %5.1f%%\n", plugin->name, count, silent, busy,
+           100.0 * silent / busy);
+  }
+  else {
+    printf("%-28s instantiate failed\n", plugin->name);
+  }
+  for (l1 = 0; l1 < count; l1++)
+    instanceFree(&insts[l1]);
+  free(insts);
+  return ok;
+}
+
+/* Library of a bundle: plugins/NAME-vcf.lv2/NAME.so */
+static void *bundleOpen(const char *dir)
+{
+  const char *base = strrchr(dir, '/') ? strrchr(dir, '/') + 1 : dir;
+  char path[1024];
+  size_t len = strcspn(base, "-");
+  void *lib;
+  snprintf(path, sizeof(path), "%s/%.*s.so", dir, (int)len, base);
+  lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if (!lib)
+    fprintf(stderr, "%s\n", dlerror());
+  return lib;
+}
+
+int main(int argc, char **argv)
+{
+  static ttlBundle bundle;
+  const LV2_Descriptor *(*lv2Descriptor)(uint32_t);
+  const LV2_Descriptor *descriptor;
+  const ttlPlugin *plugin;
+  void *lib;
+  uint32_t index;
+  int l1, first = 1, tracks = 0, failed = 0;
+  if (argc > 2 && !strcmp(argv[1], "-s")) {
+    tracks = atoi(argv[2]);
+    first = 3;
+  }
+  if (first >= argc || (first == 3 && tracks < 1)) {
+    fprintf(stderr, "usage: %s [-s TRACKS] BUNDLE...\n", argv[0]);
+    return 2;
+  }
+  srand(1);
+  for (l1 = 0; l1 < BLOCK; l1++)
+    noise[l1] = rand() / (float)RAND_MAX - 0.5f;
+  empty_sequence.atom.size = sizeof(LV2_Atom_Sequence_Body);
+  empty_sequence.atom.type = mapURI(NULL, LV2_ATOM__Sequence);
+  for (l1 = first; l1 < argc; l1++) {
+    bundleRead(&bundle, argv[l1]);
+    if (!(lib = bundleOpen(argv[l1]))) {
+      failed++;
+      continue;
+    }
+    lv2Descriptor = (const LV2_Descriptor *(*)(uint32_t))
+        dlsym(lib, "lv2_descriptor");
+    for (index = 0; lv2Descriptor
+         && (descriptor = lv2Descriptor(index)); index++) {
+      if (!(plugin = bundleFind(&bundle, descriptor->URI))) {
+        printf("FAIL %s: not in the bundle's .ttl files\n",
+               descriptor->URI);
+        failed++;
+      }
+      else if (tracks)
+        failed += !silentBench(descriptor, plugin, tracks);
+      else
+        failed += !decayCheck(descriptor, plugin);
+    }
+  }
+  if (failed)
+    printf("%d failed\n", failed);
+  return failed != 0;
+}